@@ -1,4 +1,6 @@
 #include "IncrCheckerHelpers.h"
+#include <cmath>
+#include <cstring>
 #include <unordered_map>
 
 namespace car {
@@ -8,6 +10,11 @@ Branching::Branching(int type) {
     conflict_index = 1;
     mini = 1 << 20;
     counts.clear();
+    increment = 1;
+    if (branching_type == 4) {
+        for (int t = 1; t < kNumArms; t++) arms.emplace_back(new Branching(t));
+        active = arms[0].get();
+    }
 }
 
 
@@ -16,6 +23,16 @@ Branching::~Branching() {}
 
 void Branching::Update(const cube &uc) {
     if (uc.empty()) return;
+    if (branching_type == 4) {
+        // every arm learns from every lemma, only the played one is rewarded
+        for (auto &arm : arms) arm->Update(uc);
+        lemma_count++;
+        lemma_length += uc.size();
+        double mean = lemma_length / lemma_count;
+        window_reward += mean / (mean + uc.size());
+        if (++window_lemmas >= kArmWindow) ChooseArm();
+        return;
+    }
     conflict_index++;
     switch (branching_type) {
     case 1: {
@@ -37,7 +54,11 @@ void Branching::Update(const cube &uc) {
     if (mini > abs(uc.at(0))) mini = abs(uc.at(0));
     for (auto l : uc) {
         switch (branching_type) {
-        case 1:
+        case 1: {
+            assert(abs(l) < counts.size());
+            counts[abs(l)] += increment;
+            break;
+        }
         case 2: {
             assert(abs(l) < counts.size());
             counts[abs(l)]++;
@@ -51,14 +72,101 @@ void Branching::Update(const cube &uc) {
 }
 
 
+// ================================================================================
+// @brief: close the window of the played arm and pick the next one by UCB1,
+//         an arm that was never played goes first
+// @input:
+// @output:
+// ================================================================================
+void Branching::ChooseArm() {
+    pulls[active_arm]++;
+    rewards[active_arm] += window_reward / window_lemmas;
+    window_lemmas = 0;
+    window_reward = 0;
+
+    double total = 0;
+    for (int a = 0; a < kNumArms; a++) total += pulls[a];
+    int best = 0;
+    double best_score = -1;
+    for (int a = 0; a < kNumArms; a++) {
+        if (pulls[a] == 0) {
+            best = a;
+            break;
+        }
+        double score = rewards[a] / pulls[a] + sqrt(2 * log(total) / pulls[a]);
+        if (score > best_score) {
+            best_score = score;
+            best = a;
+        }
+    }
+    active_arm = best;
+    active = best < arms.size() ? arms[best].get() : nullptr;
+}
+
+
+// ================================================================================
+// @brief: scaling every count by 0.99 is the same as growing the increment by 1 / 0.99,
+//         the counts are only rescaled when the increment gets too large
+// @input:
+// @output:
+// ================================================================================
 void Branching::Decay() {
+    increment /= 0.99f;
+    if (increment < kRescaleLimit) return;
     for (int i = mini; i < counts.size(); i++)
-        counts[i] *= 0.99;
+        counts[i] /= kRescaleLimit;
+    increment /= kRescaleLimit;
+}
+
+
+// descending float order as ascending unsigned order
+static inline uint32_t DescendingKey(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return ~bits;
+}
+
+
+// ================================================================================
+// @brief: same order as stable_sort with PriorityOf, large cubes go through
+//         an LSD radix sort over the key bytes
+// @input:
+// @output:
+// ================================================================================
+void Branching::Order(cube &c) {
+    size_t n = c.size();
+    if (n < 2) return;
+    keyed.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        keyed[i] = {DescendingKey(PriorityOf(c[i])), c[i]};
+    }
+
+    if (n < kRadixThreshold) {
+        stable_sort(keyed.begin(), keyed.end(),
+                    [](const pair<uint32_t, int> &a, const pair<uint32_t, int> &b) { return a.first < b.first; });
+    } else {
+        keyed_tmp.resize(n);
+        for (int shift = 0; shift < 32; shift += 8) {
+            size_t buckets[257] = {0};
+            for (auto &k : keyed) buckets[((k.first >> shift) & 0xFF) + 1]++;
+            if (buckets[((keyed[0].first >> shift) & 0xFF) + 1] == n) continue;
+            for (int b = 0; b < 256; ++b) buckets[b + 1] += buckets[b];
+            for (auto &k : keyed) keyed_tmp[buckets[(k.first >> shift) & 0xFF]++] = k;
+            keyed.swap(keyed_tmp);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) c[i] = keyed[i].second;
 }
 
 
 void Branching::Decay(const cube &uc, int gap) {
     if (uc.empty()) return;
+    if (branching_type == 4) {
+        for (auto &arm : arms) arm->Decay(uc, gap);
+        return;
+    }
     conflict_index++;
     // assumes cube is ordered
     int sz = abs(uc.back());
@@ -70,25 +178,56 @@ void Branching::Decay(const cube &uc, int gap) {
 }
 
 
-static bool _cmp(int a, int b) {
-    if (abs(a) != abs(b))
-        return abs(a) < abs(b);
-    else
-        return a < b;
-}
-
-
 // ================================================================================
-// @brief: if a implies b
+// @brief: list the lemma under its literal with the shortest list,
+//         the elements of a frame keep their address until they are erased
 // @input:
 // @output:
 // ================================================================================
-bool OverSequenceSet::Imply(const cube &a, const cube &b) {
-    if (a.size() > b.size())
-        return false;
-    return (includes(b.begin(), b.end(), a.begin(), a.end(), _cmp));
+void OverSequenceSet::Watch(int frameLevel, const cube *uc) {
+    auto &watches = m_watches[frameLevel];
+    int best_lit = 0;
+    size_t best_size = SIZE_MAX;
+    for (int lit : *uc) {
+        auto it = watches.find(lit);
+        size_t size = it == watches.end() ? 0 : it->second.cubes.size();
+        if (size < best_size) {
+            best_size = size;
+            best_lit = lit;
+        }
+    }
+    auto &list = watches[best_lit];
+    list.sigs.emplace_back(CubeSignature(*uc));
+    list.cubes.emplace_back(uc);
 }
 
+
+void OverSequenceSet::Unwatch(int frameLevel, const cube *uc) {
+    auto &watches = m_watches[frameLevel];
+    auto remove = [&](int lit) {
+        auto it = watches.find(lit);
+        if (it == watches.end()) return false;
+        auto &list = it->second;
+        auto pos = find(list.cubes.begin(), list.cubes.end(), uc);
+        if (pos == list.cubes.end()) return false;
+        size_t i = pos - list.cubes.begin();
+        list.cubes[i] = list.cubes.back();
+        list.cubes.pop_back();
+        list.sigs[i] = list.sigs.back();
+        list.sigs.pop_back();
+        if (list.cubes.empty()) watches.erase(it);
+        return true;
+    };
+    if (uc->empty()) {
+        remove(0);
+        return;
+    }
+    for (int lit : *uc) {
+        if (remove(lit)) return;
+    }
+}
+
+
 void OverSequenceSet::EnsureTmpLitCapacity(const cube &latches) {
     int max_abs = 0;
     for (int lit : latches) {
@@ -124,17 +263,53 @@ void OverSequenceSet::ClearTmpLitSet() {
 }
 
 
+void LemmaBus::Publish(const cube &lemma, int level, int source) {
+    Entry e{lemma, level, source};
+    sort(e.lemma.begin(), e.lemma.end(), cmp);
+    lock_guard<mutex> lock(m_mutex);
+    if (m_ring.size() < m_capacity)
+        m_ring.emplace_back(std::move(e));
+    else
+        m_ring[m_published % m_capacity] = std::move(e);
+    m_published++;
+}
+
+
+void LemmaBus::Collect(uint64_t &cursor, int source, vector<Entry> &entries) {
+    lock_guard<mutex> lock(m_mutex);
+    uint64_t oldest = m_published - m_ring.size();
+    for (uint64_t i = max(cursor, oldest); i < m_published; ++i) {
+        const Entry &e = m_ring[i % m_capacity];
+        if (e.source != source) entries.emplace_back(e);
+    }
+    cursor = m_published;
+}
+
+
 bool OverSequenceSet::Insert(const cube &uc, int index) {
     auto f = GetFrame(index);
     if (f->find(uc) != f->end()) return false;
 
-    f->emplace(uc);
-    int &counter = m_insertCounter[index];
-    counter++;
-    if (counter >= kCleanupThreshold) {
-        counter = 0;
-        CleanupImplied(index);
+    // backward, a lemma of the frame that is a subset of uc blocks more already
+    if (IsBlockedByFrame(uc, index)) return false;
+    // forward, the lemmas uc is a subset of are redundant now
+    EraseSubsumed(index, uc);
+
+    auto pooled = m_lemmaPool.emplace(uc, 0).first;
+    pooled->second++;
+    const cube *lemma = &pooled->first;
+    f->m_lemmas.emplace(lemma);
+    Watch(index, lemma);
+    uint64_t sig = CubeSignature(uc);
+    for (int lit : uc) {
+        auto &list = m_occurs[index][lit];
+        list.sigs.emplace_back(sig);
+        list.cubes.emplace_back(lemma);
     }
+    if (m_packWords > 0) PackedInsert(index, lemma);
+    m_frameVersions[index]++;
+    if (m_lemmaBus != nullptr && m_publish && index > 0)
+        m_lemmaBus->Publish(uc, index, m_lemmaSource);
 
     return true;
 }
@@ -143,92 +318,278 @@ bool OverSequenceSet::Insert(const cube &uc, int index) {
 shared_ptr<frame> OverSequenceSet::GetFrame(int lvl) {
     while (lvl >= m_sequence.size()) {
         m_sequence.emplace_back(make_shared<frame>());
+        m_watches.emplace_back();
+        m_occurs.emplace_back();
+        m_packed.emplace_back();
+        m_eraseEpochs.emplace_back(0);
+        m_frameVersions.emplace_back(0);
         m_blockCounter.emplace_back(0);
-        m_insertCounter.emplace_back(0);
     }
     return m_sequence[lvl];
 }
 
 
-void OverSequenceSet::CleanupImplied(int frameLevel) {
-    auto f = GetFrame(frameLevel);
+// ================================================================================
+// @brief: erase the lemmas of the frame that contain every literal of uc,
+//         they are found in the occurrence list of the rarest literal of uc
+// @input:
+// @output:
+// ================================================================================
+void OverSequenceSet::EraseSubsumed(int frameLevel, const cube &uc) {
+    vector<const cube *> subsumed;
+    if (uc.empty()) {
+        for (const cube &c : *m_sequence[frameLevel]) subsumed.emplace_back(&c);
+    } else {
+        auto &occurs = m_occurs[frameLevel];
+        const SignedCubes *best = nullptr;
+        for (int lit : uc) {
+            auto it = occurs.find(lit);
+            if (it == occurs.end()) return;
+            if (best == nullptr || it->second.cubes.size() < best->cubes.size()) best = &it->second;
+        }
 
-    vector<cube> cubes;
-    cubes.reserve(f->size());
-    for (const auto &uc : *f) {
-        cubes.emplace_back(uc);
+        EnsureTmpLitCapacity(uc);
+        for (int lit : uc) {
+            TmpLitSetInsert(lit);
+        }
+        uint64_t sig = CubeSignature(uc);
+        for (size_t i = 0; i < best->cubes.size(); ++i) {
+            if ((sig & ~best->sigs[i]) != 0) continue;
+            const cube *c = best->cubes[i];
+            if (c->size() <= uc.size()) continue;
+            size_t found = 0;
+            for (int lit : *c) found += TmpLitSetHas(lit);
+            if (found == uc.size()) subsumed.emplace_back(c);
+        }
+        ClearTmpLitSet();
     }
+    for (const cube *c : subsumed) EraseFromFrame(frameLevel, c);
+}
 
-    sort(cubes.begin(), cubes.end(), [](const cube &a, const cube &b) {
-        if (a.size() != b.size()) return a.size() < b.size();
-        return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), _cmp);
-    });
 
-    unordered_map<int, vector<size_t>> occurs;
-    occurs.reserve(cubes.size() * 4);
-    for (size_t i = 0; i < cubes.size(); ++i) {
-        for (int lit : cubes[i]) {
-            occurs[lit].emplace_back(i);
-        }
+void OverSequenceSet::EraseFromFrame(int frameLevel, const cube *uc) {
+    Unwatch(frameLevel, uc);
+    auto &occurs = m_occurs[frameLevel];
+    for (int lit : *uc) {
+        auto it = occurs.find(lit);
+        auto &list = it->second;
+        size_t i = find(list.cubes.begin(), list.cubes.end(), uc) - list.cubes.begin();
+        list.cubes[i] = list.cubes.back();
+        list.cubes.pop_back();
+        list.sigs[i] = list.sigs.back();
+        list.sigs.pop_back();
+        if (list.cubes.empty()) occurs.erase(it);
     }
+    if (m_packWords > 0) PackedErase(frameLevel, uc);
+    m_eraseEpochs[frameLevel]++;
+    m_frameVersions[frameLevel]++;
+    m_sequence[frameLevel]->m_lemmas.erase(uc);
+    auto pooled = m_lemmaPool.find(*uc);
+    if (--pooled->second == 0) m_lemmaPool.erase(pooled);
+}
 
-    vector<bool> remove(cubes.size(), false);
-    for (size_t i = 0; i < cubes.size(); ++i) {
-        if (remove[i]) continue;
 
-        int best_lit = cubes[i][0];
-        size_t best_occ = occurs[best_lit].size();
-        for (int lit : cubes[i]) {
-            auto it = occurs.find(lit);
-            if (it == occurs.end()) continue;
-            size_t occ_size = it->second.size();
-            if (occ_size < best_occ) {
-                best_occ = occ_size;
-                best_lit = lit;
-            }
-        }
-        for (size_t idx : occurs[best_lit]) {
-            if (idx == i || remove[idx]) continue;
-            if (Imply(cubes[i], cubes[idx])) {
-                remove[idx] = true;
-            }
-        }
+void OverSequenceSet::SetPacked() {
+    const vector<int> &latches = m_model.GetModelLatches();
+    int max_var = m_model.NumVar();
+    for (int v : latches) max_var = max(max_var, v);
+    m_packPos.assign(max_var + 1, -1);
+    for (size_t i = 0; i < latches.size(); ++i) m_packPos[latches[i]] = i;
+    m_packWords = (latches.size() + 63) / 64;
+    if (m_packWords == 0) m_packWords = 1;
+    m_tmpPacked.assign(2 * m_packWords, 0);
+    for (int i = 0; i < m_sequence.size(); ++i) {
+        for (const cube &uc : *m_sequence[i]) PackedInsert(i, &uc);
     }
+}
 
-    for (size_t i = 0; i < cubes.size(); ++i) {
-        if (remove[i]) {
-            f->erase(cubes[i]);
+
+// ================================================================================
+// @brief: pack a cube into the mask and value rows of out
+// @input: out has room for 2 * m_packWords words
+// @output: false if the cube has a literal that is no model latch, it is left out
+// ================================================================================
+bool OverSequenceSet::PackCube(const cube &c, uint64_t *out) {
+    fill(out, out + 2 * m_packWords, 0);
+    bool all = true;
+    for (int lit : c) {
+        int v = abs(lit);
+        int pos = v < m_packPos.size() ? m_packPos[v] : -1;
+        if (pos < 0) {
+            all = false;
+            continue;
         }
+        uint64_t bit = uint64_t(1) << (pos & 63);
+        out[pos >> 6] |= bit;
+        if (lit > 0) out[m_packWords + (pos >> 6)] |= bit;
     }
+    return all;
 }
 
 
-bool OverSequenceSet::IsBlockedByFrame(const cube &latches, int frameLevel) {
-    auto f = GetFrame(frameLevel);
-    if (f->empty()) return false;
+void OverSequenceSet::PackedInsert(int frameLevel, const cube *uc) {
+    PackedCubes &packed = m_packed[frameLevel];
+    size_t first = packed.bits.size();
+    packed.bits.resize(first + 2 * m_packWords);
+    if (PackCube(*uc, packed.bits.data() + first)) {
+        packed.cubes.emplace_back(uc);
+    } else {
+        packed.bits.resize(first);
+        packed.loose.emplace_back(uc);
+    }
+}
+
+
+void OverSequenceSet::PackedErase(int frameLevel, const cube *uc) {
+    PackedCubes &packed = m_packed[frameLevel];
+    auto loose = find(packed.loose.begin(), packed.loose.end(), uc);
+    if (loose != packed.loose.end()) {
+        *loose = packed.loose.back();
+        packed.loose.pop_back();
+        return;
+    }
+    size_t i = find(packed.cubes.begin(), packed.cubes.end(), uc) - packed.cubes.begin();
+    size_t row = 2 * m_packWords;
+    copy(packed.bits.end() - row, packed.bits.end(), packed.bits.begin() + i * row);
+    packed.bits.resize(packed.bits.size() - row);
+    packed.cubes[i] = packed.cubes.back();
+    packed.cubes.pop_back();
+}
+
+
+const cube *OverSequenceSet::FindBlockerPacked(const cube &latches, int frameLevel) {
+    // literals of the state that are no model latch are not in any packed lemma
+    PackCube(latches, m_tmpPacked.data());
+    const PackedCubes &packed = m_packed[frameLevel];
+    size_t row = 2 * m_packWords;
+    const uint64_t *bits = packed.bits.data();
+    for (size_t i = 0; i < packed.cubes.size(); ++i) {
+        if (PackedBlocks(bits + i * row, m_tmpPacked.data(), m_packWords)) return packed.cubes[i];
+    }
+    if (packed.loose.empty()) return nullptr;
 
     EnsureTmpLitCapacity(latches);
     for (int lit : latches) {
         TmpLitSetInsert(lit);
     }
-
-    size_t latches_size = latches.size();
-    for (const auto &uc : *f) {
-        if (uc.size() > latches_size) continue;
+    const cube *blocker = nullptr;
+    for (const cube *uc : packed.loose) {
+        if (uc->size() > latches.size()) continue;
         bool subsumed = true;
-        for (int lit : uc) {
+        for (int lit : *uc) {
             if (!TmpLitSetHas(lit)) {
                 subsumed = false;
                 break;
             }
         }
         if (subsumed) {
-            ClearTmpLitSet();
-            return true;
+            blocker = uc;
+            break;
         }
     }
     ClearTmpLitSet();
-    return false;
+    return blocker;
+}
+
+
+bool OverSequenceSet::IsBlockedByFrame(const cube &latches, int frameLevel) {
+    return FindBlocker(latches, frameLevel) != nullptr;
+}
+
+
+BlockerMemo &OverSequenceSet::GetBlockerMemo(const cube &latches) {
+    if (m_blockerMemos.size() >= kMaxBlockerMemos && m_blockerMemos.find(latches) == m_blockerMemos.end())
+        PruneBlockerMemos();
+    return m_blockerMemos[latches];
+}
+
+
+// ================================================================================
+// @brief: drop the memos whose frames all erased lemmas since they were written,
+//         they would miss anyway; all of them if that frees less than half
+// @input:
+// @output:
+// ================================================================================
+void OverSequenceSet::PruneBlockerMemos() {
+    for (auto it = m_blockerMemos.begin(); it != m_blockerMemos.end();) {
+        const BlockerMemo &memo = it->second;
+        bool live = false;
+        for (size_t i = 0; i < memo.lemmas.size() && !live; ++i)
+            live = memo.lemmas[i] != nullptr && memo.epochs[i] == m_eraseEpochs[i];
+        if (live)
+            ++it;
+        else
+            it = m_blockerMemos.erase(it);
+    }
+    if (m_blockerMemos.size() >= kMaxBlockerMemos / 2) m_blockerMemos.clear();
+}
+
+
+// ================================================================================
+// @brief: IsBlockedByFrame that first tries the lemma which blocked the cube last time,
+//         it still blocks if the frame has not erased any lemma since
+// @input: memo of the cube, from GetBlockerMemo
+// @output:
+// ================================================================================
+bool OverSequenceSet::IsBlockedByFrame(const cube &latches, int frameLevel, BlockerMemo &memo) {
+    GetFrame(frameLevel);
+    uint64_t epoch = m_eraseEpochs[frameLevel];
+    if (frameLevel < memo.lemmas.size() && memo.lemmas[frameLevel] != nullptr &&
+        memo.epochs[frameLevel] == epoch)
+        return true;
+
+    const cube *blocker = FindBlocker(latches, frameLevel);
+    if (blocker == nullptr) return false;
+    if (frameLevel >= memo.lemmas.size()) {
+        memo.lemmas.resize(frameLevel + 1, nullptr);
+        memo.epochs.resize(frameLevel + 1, 0);
+    }
+    memo.lemmas[frameLevel] = blocker;
+    memo.epochs[frameLevel] = epoch;
+    return true;
+}
+
+
+const cube *OverSequenceSet::FindBlocker(const cube &latches, int frameLevel) {
+    auto f = GetFrame(frameLevel);
+    if (f->empty()) return nullptr;
+    if (m_packWords > 0) return FindBlockerPacked(latches, frameLevel);
+
+    const auto &watches = m_watches[frameLevel];
+    auto empty = watches.find(0);
+    if (empty != watches.end()) return empty->second.cubes[0];
+
+    EnsureTmpLitCapacity(latches);
+    for (int lit : latches) {
+        TmpLitSetInsert(lit);
+    }
+
+    size_t latches_size = latches.size();
+    uint64_t sig = CubeSignature(latches);
+    for (int l : latches) {
+        auto it = watches.find(l);
+        if (it == watches.end()) continue;
+        const SignedCubes &list = it->second;
+        if (m_tmpIndexes.size() < list.sigs.size()) m_tmpIndexes.resize(list.sigs.size());
+        size_t n = FilterSignatures(list.sigs.data(), list.sigs.size(), sig, m_tmpIndexes.data());
+        for (size_t k = 0; k < n; ++k) {
+            const cube *uc = list.cubes[m_tmpIndexes[k]];
+            if (uc->size() > latches_size) continue;
+            bool subsumed = true;
+            for (int lit : *uc) {
+                if (!TmpLitSetHas(lit)) {
+                    subsumed = false;
+                    break;
+                }
+            }
+            if (subsumed) {
+                ClearTmpLitSet();
+                return uc;
+            }
+        }
+    }
+    ClearTmpLitSet();
+    return nullptr;
 }
 
 
@@ -236,23 +597,36 @@ void OverSequenceSet::GetBlockers(const cube &latches, int framelevel, vector<cu
     auto f = GetFrame(framelevel);
     if (f->empty()) return;
 
+    const auto &watches = m_watches[framelevel];
+    auto empty = watches.find(0);
+    if (empty != watches.end()) b.emplace_back(*empty->second.cubes[0]);
+
     EnsureTmpLitCapacity(latches);
     for (int lit : latches) {
         TmpLitSetInsert(lit);
     }
 
     size_t latches_size = latches.size();
-    for (const auto &uc : *f) {
-        if (uc.size() > latches_size) continue;
-        bool subsumed = true;
-        for (int lit : uc) {
-            if (!TmpLitSetHas(lit)) {
-                subsumed = false;
-                break;
+    uint64_t sig = CubeSignature(latches);
+    for (int l : latches) {
+        auto it = watches.find(l);
+        if (it == watches.end()) continue;
+        const SignedCubes &list = it->second;
+        if (m_tmpIndexes.size() < list.sigs.size()) m_tmpIndexes.resize(list.sigs.size());
+        size_t n = FilterSignatures(list.sigs.data(), list.sigs.size(), sig, m_tmpIndexes.data());
+        for (size_t k = 0; k < n; ++k) {
+            const cube *uc = list.cubes[m_tmpIndexes[k]];
+            if (uc->size() > latches_size) continue;
+            bool subsumed = true;
+            for (int lit : *uc) {
+                if (!TmpLitSetHas(lit)) {
+                    subsumed = false;
+                    break;
+                }
+            }
+            if (subsumed) {
+                b.emplace_back(*uc);
             }
-        }
-        if (subsumed) {
-            b.emplace_back(uc);
         }
     }
     ClearTmpLitSet();
@@ -287,11 +661,267 @@ string OverSequenceSet::FramesDetail() {
 }
 
 
-int State::numInputs = -1;
-int State::numLatches = -1;
+// ================================================================================
+// @brief: O_i & !O_0 & ... & !O_(i-1) is unsat
+// @input:
+// @output:
+// ================================================================================
+bool InvariantChecker::Check(int frameLevel) {
+    cube assumption;
+    for (int i = 0; i < frameLevel; ++i) {
+        assumption.emplace_back(GetOutsideLiteral(i));
+    }
+    for (const cube &lemma : *m_sequence->GetFrame(frameLevel)) {
+        assumption.emplace_back(GetFlags(lemma).blocked);
+    }
+    return !m_solver->Solve(assumption);
+}
+
+
+const InvariantChecker::LemmaFlags &InvariantChecker::GetFlags(const cube &lemma) {
+    auto it = m_flags.find(lemma);
+    if (it != m_flags.end()) return it->second;
+
+    LemmaFlags flags{m_solver->GetNewVar(), m_solver->GetNewVar()};
+    cube cls;
+    for (int l : lemma) {
+        m_solver->AddClause(cube{-flags.sat, l});
+        cls.emplace_back(-l);
+    }
+    cls.emplace_back(-flags.blocked);
+    m_solver->AddClause(cls);
+    return m_flags.emplace(lemma, flags).first->second;
+}
+
+
+// ================================================================================
+// @brief: the literal under which the state is outside O_i, that is it satisfies
+//         one of the lemmas, a frame that changed gets a new one and the old is set false
+// @input:
+// @output:
+// ================================================================================
+int InvariantChecker::GetOutsideLiteral(int frameLevel) {
+    uint64_t version = m_sequence->GetFrameVersion(frameLevel);
+    if (frameLevel < m_outside.size() && m_outsideVersions[frameLevel] == version)
+        return m_outside[frameLevel];
+    if (frameLevel >= m_outside.size()) {
+        m_outside.resize(frameLevel + 1, 0);
+        m_outsideVersions.resize(frameLevel + 1, 0);
+    } else {
+        m_solver->AddClause(cube{-m_outside[frameLevel]});
+    }
+
+    int act = m_solver->GetNewVar();
+    cube cls{-act};
+    for (const cube &lemma : *m_sequence->GetFrame(frameLevel)) {
+        cls.emplace_back(GetFlags(lemma).sat);
+    }
+    m_solver->AddClause(cls);
+    m_outside[frameLevel] = act;
+    m_outsideVersions[frameLevel] = version;
+    return act;
+}
+
+
+void SolverCompactor::LemmaAdded(int lvl, const cube &lemma) {
+    for (auto &r : m_rebuilds) {
+        if (r.lvl == lvl) {
+            r.pending.emplace_back(lemma);
+            return;
+        }
+    }
+
+    if (lvl >= m_builtErased.size()) m_builtErased.resize(lvl + 1, 0);
+    uint64_t erased = m_sequence->GetErasedCount(lvl);
+    uint64_t dead = erased - m_builtErased[lvl];
+    shared_ptr<frame> f = m_sequence->GetFrame(lvl);
+    if (dead < kMinDeadLemmas || dead < f->size()) return;
+
+    // the frame keeps changing, the background thread gets a copy of its lemmas
+    vector<cube> lemmas(f->begin(), f->end());
+    m_rebuilds.push_back(Rebuild{lvl, erased, {}, {}});
+    CloneFn clone = m_clone;
+    m_rebuilds.back().solver = async(launch::async, [clone, lvl, lemmas = move(lemmas)]() {
+        return clone(lvl, lemmas);
+    });
+}
+
+
+int SolverCompactor::Collect(vector<shared_ptr<SATSolver>> &solvers) {
+    int swapped = 0;
+    for (size_t i = 0; i < m_rebuilds.size();) {
+        Rebuild &r = m_rebuilds[i];
+        if (r.solver.wait_for(chrono::seconds(0)) != future_status::ready) {
+            ++i;
+            continue;
+        }
+        shared_ptr<SATSolver> slv = r.solver.get();
+        for (const cube &lemma : r.pending) m_add(*slv, lemma);
+        solvers[r.lvl] = slv;
+        m_builtErased[r.lvl] = r.erased;
+        swapped++;
+        m_rebuilds[i] = move(m_rebuilds.back());
+        m_rebuilds.pop_back();
+    }
+    return swapped;
+}
+
+
+void CompactLevelLemmas(vector<cube> &lemmas, vector<pair<shared_ptr<SATSolver>, size_t>> &slots, const frame &f) {
+    size_t held = lemmas.size();
+    for (auto &slot : slots)
+        if (slot.first != nullptr) held = min(held, slot.second);
+
+    // kept[i - held] is the number of lemmas kept before lemmas[i]
+    vector<size_t> kept(lemmas.size() - held + 1, 0);
+    size_t n = 0;
+    for (size_t i = held; i < lemmas.size(); ++i) {
+        kept[i - held] = n;
+        if (f.find(lemmas[i]) == f.end()) continue;
+        if (n != i) lemmas[n] = std::move(lemmas[i]);
+        n++;
+    }
+    kept.back() = n;
+    lemmas.resize(n);
+    for (auto &slot : slots)
+        if (slot.first != nullptr) slot.second = kept[slot.second - held];
+}
+
+
+StatePool::~StatePool() {
+    for (void *slab : m_slabs) ::operator delete(slab);
+}
+
+
+void *StatePool::Allocate(size_t bytes) {
+    unique_lock<mutex> lock(m_mutex, defer_lock);
+    if (m_shared) lock.lock();
+    if (m_blockSize == 0) {
+        size_t align = alignof(max_align_t);
+        m_blockSize = max((bytes + align - 1) / align * align, sizeof(void *));
+    }
+    if (bytes > m_blockSize || bytes + alignof(max_align_t) <= m_blockSize)
+        return ::operator new(bytes);
+
+    if (m_free == nullptr) {
+        char *slab = static_cast<char *>(::operator new(m_blockSize * kSlabBlocks));
+        m_slabs.emplace_back(slab);
+        for (size_t i = 0; i < kSlabBlocks; ++i) {
+            void *block = slab + i * m_blockSize;
+            *static_cast<void **>(block) = m_free;
+            m_free = block;
+        }
+    }
+    void *block = m_free;
+    m_free = *static_cast<void **>(block);
+    return block;
+}
+
+
+void StatePool::Deallocate(void *p, size_t bytes) {
+    unique_lock<mutex> lock(m_mutex, defer_lock);
+    if (m_shared) lock.lock();
+    if (bytes > m_blockSize || bytes + alignof(max_align_t) <= m_blockSize) {
+        ::operator delete(p);
+        return;
+    }
+    *static_cast<void **>(p) = m_free;
+    m_free = p;
+}
+
+
+// ================================================================================
+// @brief: drop the lowest dt scores until a quarter of the capacity is free,
+//         the predecessors of the kept states stay alive through their preState
+// @input:
+// @output:
+// ================================================================================
+void UnderSequence::Evict() {
+    vector<double> scores;
+    scores.reserve(m_count);
+    for (auto &states : m_sequence) {
+        for (auto &s : states) scores.emplace_back(s->dtScore);
+    }
+    size_t keep = m_capacity - m_capacity / 4;
+    auto nth = scores.end() - keep;
+    nth_element(scores.begin(), nth, scores.end());
+    double threshold = *nth;
+    // the states at the threshold score are kept in depth order until keep is reached
+    size_t above = count_if(scores.begin(), scores.end(), [&](double d) { return d > threshold; });
+    size_t ties = keep - above;
+
+    m_count = 0;
+    for (auto &states : m_sequence) {
+        size_t j = 0;
+        for (auto &s : states) {
+            if (s->dtScore < threshold) continue;
+            if (s->dtScore == threshold) {
+                if (ties == 0) continue;
+                ties--;
+            }
+            states[j++] = s;
+        }
+        states.resize(j);
+        m_count += j;
+    }
+    RebuildHeap();
+}
+
+
+void UnderSequence::SiftUp(size_t pos) {
+    shared_ptr<State> s = move(m_heap[pos]);
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (m_heap[parent]->dtScore >= s->dtScore) break;
+        m_heap[pos] = move(m_heap[parent]);
+        m_heap[pos]->heapPos = pos;
+        pos = parent;
+    }
+    s->heapPos = pos;
+    m_heap[pos] = move(s);
+}
+
+
+void UnderSequence::RebuildHeap() {
+    m_heap.clear();
+    for (auto &states : m_sequence) {
+        for (auto &s : states) {
+            s->heapPos = m_heap.size();
+            m_heap.emplace_back(s);
+            SiftUp(s->heapPos);
+        }
+    }
+}
+
+
+// ================================================================================
+// @brief: the best k states are taken from the heap without touching the others,
+//         the frontier holds the heap positions whose parents are taken already
+// @input:
+// @output: the top fifth by dtScore, O(k log k)
+// ================================================================================
+vector<shared_ptr<State>> UnderSequence::GetSeqDT() {
+    size_t k = m_heap.size() / 5;
+    vector<shared_ptr<State>> res;
+    res.reserve(k);
+    auto lower = [&](size_t a, size_t b) { return m_heap[a]->dtScore < m_heap[b]->dtScore; };
+    m_frontier.clear();
+    if (k > 0) m_frontier.emplace_back(0);
+    while (res.size() < k) {
+        pop_heap(m_frontier.begin(), m_frontier.end(), lower);
+        size_t pos = m_frontier.back();
+        m_frontier.pop_back();
+        res.emplace_back(m_heap[pos]);
+        for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < m_heap.size(); ++child) {
+            m_frontier.emplace_back(child);
+            push_heap(m_frontier.begin(), m_frontier.end(), lower);
+        }
+    }
+    return res;
+}
 
 
-string State::GetLatchesString() {
+string State::GetLatchesString(int numInputs, int numLatches) {
     string result = "";
     result.reserve(numLatches);
     int j = 0;
@@ -307,7 +937,7 @@ string State::GetLatchesString() {
 }
 
 
-string State::GetInputsString() {
+string State::GetInputsString(int numInputs) {
     string result = "";
     result.reserve(numInputs);
     int j = 0;
@@ -6,11 +6,18 @@
 #include "SATSolver.h"
 #include "Settings.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace car {
@@ -24,15 +31,41 @@ class Branching {
     void Decay(const cube &uc, int gap);
 
     inline float PriorityOf(int lit) {
+        if (branching_type == 4) return active == nullptr ? 0 : active->PriorityOf(lit);
         if (abs(lit) >= counts.size()) return 0;
         return counts[abs(lit)];
     }
 
+    // stable sort of c by descending priority, the keys are read once
+    void Order(cube &c);
+
   private:
-    int branching_type; // 1: sum 2: vsids 3: acids 4: MAB (to do) 0: static
+    static constexpr float kRescaleLimit = 1e20f;
+    static constexpr size_t kRadixThreshold = 256;
+    static constexpr int kArmWindow = 64;
+    static constexpr int kNumArms = 4;
+
+    void ChooseArm();
+
+    int branching_type; // 1: sum 2: vsids 3: acids 4: MAB 0: static
     int conflict_index;
     int mini;
     std::vector<float> counts;
+    // type 1 decays lazily, the increment grows instead of every count shrinking
+    float increment;
+    std::vector<pair<uint32_t, int>> keyed;
+    std::vector<pair<uint32_t, int>> keyed_tmp;
+    // MAB: UCB1 over sum, vsids, acids and static, the arm that is played orders
+    // the literals for a window of lemmas and is rewarded for short ones
+    std::vector<unique_ptr<Branching>> arms;
+    Branching *active = nullptr;
+    int active_arm = 0;
+    int window_lemmas = 0;
+    double window_reward = 0;
+    double pulls[kNumArms] = {0};
+    double rewards[kNumArms] = {0};
+    double lemma_count = 0;
+    double lemma_length = 0;
 };
 
 
@@ -46,14 +79,211 @@ struct CubeHash {
     }
 };
 
-using frame = unordered_set<cube, CubeHash>;
+// a frame is a view on the lemma pool of an OverSequenceSet,
+// a lemma on several levels is stored once and every frame holds its address
+class frame {
+  public:
+    struct PtrHash {
+        size_t operator()(const cube *c) const noexcept { return CubeHash()(*c); }
+    };
+    struct PtrEqual {
+        bool operator()(const cube *a, const cube *b) const noexcept { return *a == *b; }
+    };
+    using lemma_set = unordered_set<const cube *, PtrHash, PtrEqual>;
+
+    class const_iterator {
+      public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = cube;
+        using difference_type = ptrdiff_t;
+        using pointer = const cube *;
+        using reference = const cube &;
+
+        const_iterator() {}
+        explicit const_iterator(lemma_set::const_iterator it) : m_it(it) {}
+
+        reference operator*() const { return **m_it; }
+        pointer operator->() const { return *m_it; }
+        const_iterator &operator++() {
+            ++m_it;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++m_it;
+            return tmp;
+        }
+        bool operator==(const const_iterator &other) const { return m_it == other.m_it; }
+        bool operator!=(const const_iterator &other) const { return m_it != other.m_it; }
+
+      private:
+        lemma_set::const_iterator m_it;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(m_lemmas.begin()); }
+    const_iterator end() const { return const_iterator(m_lemmas.end()); }
+    const_iterator find(const cube &c) const { return const_iterator(m_lemmas.find(&c)); }
+    size_t size() const { return m_lemmas.size(); }
+    bool empty() const { return m_lemmas.empty(); }
+
+  private:
+    friend class OverSequenceSet;
+    lemma_set m_lemmas;
+};
+
+
+// 64-bit Bloom signature of a cube, a is a subset of b only if the bits of a are bits of b
+inline uint64_t LitSignature(int lit) {
+    return uint64_t(1) << ((static_cast<uint32_t>(lit) * 0x9E3779B1u) >> 26);
+}
+
+inline uint64_t CubeSignature(const cube &c) {
+    uint64_t sig = 0;
+    for (int lit : c) sig |= LitSignature(lit);
+    return sig;
+}
+
+// writes the indexes i < n with sigs[i] a subset of sig to out and returns their number,
+// the loop has no branch so that the compiler vectorizes it, out has room for n indexes
+inline size_t FilterSignatures(const uint64_t *sigs, size_t n, uint64_t sig, uint32_t *out) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        out[count] = static_cast<uint32_t>(i);
+        count += (sigs[i] & ~sig) == 0;
+    }
+    return count;
+}
+
+// a cube over the model latches packed into two bit rows of words each, the latches
+// it has and their values, bit i stands for latch i of GetModelLatches().
+// the lemma blocks the state if it has no latch the state lacks and agrees on the values,
+// the loop has no branch so that the compiler vectorizes it
+inline bool PackedBlocks(const uint64_t *lemma, const uint64_t *state, size_t words) {
+    uint64_t miss = 0;
+    for (size_t w = 0; w < words; ++w) {
+        miss |= (lemma[w] & ~state[w]) | ((lemma[words + w] ^ state[words + w]) & lemma[w]);
+    }
+    return miss == 0;
+}
+
+// the packed lemmas of a frame in one contiguous array,
+// lemmas with a literal that is no model latch are kept as cubes in loose
+struct PackedCubes {
+    vector<uint64_t> bits;
+    vector<const cube *> cubes;
+    vector<const cube *> loose;
+};
+
+// per level, the lemma that blocked a latch cube and the erase epoch of the frame then
+struct BlockerMemo {
+    vector<const cube *> lemmas;
+    vector<uint64_t> epochs;
+};
+
+// cubes and their signatures in two contiguous arrays
+struct SignedCubes {
+    vector<uint64_t> sigs;
+    vector<const cube *> cubes;
+};
+
+// the failed states of Down and their signatures
+struct FailedStates {
+    vector<uint64_t> sigs;
+    vector<cube> cubes;
+
+    void emplace_back(const cube &c) {
+        sigs.emplace_back(CubeSignature(c));
+        cubes.emplace_back(c);
+    }
+};
+
+
+inline size_t DropLitIndex(int l) { return 2 * static_cast<size_t>(abs(l)) + (l < 0); }
+
+// per-thread literal flags of DropLiterals, cleared again before every tryDrop
+// since the drop may generalize a ctg and get back into DropLiterals
+inline vector<uint8_t> &DropLitFlags(const cube &c) {
+    thread_local vector<uint8_t> flags;
+    for (int l : c)
+        if (DropLitIndex(l) >= flags.size()) flags.resize(DropLitIndex(l) + 1, 0);
+    return flags;
+}
+
+
+// divide-and-conquer literal dropping: the whole group is dropped from c with one
+// query, a group that cannot go is split and its halves are tried one after another.
+// tryDrop(candidate, single) returns true and may shrink the candidate further when
+// the candidate is still blocked, literals that must stay are put into required.
+template <typename Set, typename DropFn>
+void DropLiterals(cube &c, cube group, Set &required, DropFn &tryDrop, int &queries) {
+    vector<uint8_t> &flags = DropLitFlags(c);
+    // literals of an earlier, smaller core are gone already
+    for (int l : c) flags[DropLitIndex(l)] = 1;
+    group.erase(remove_if(group.begin(), group.end(), [&](int l) {
+                    size_t idx = DropLitIndex(l);
+                    return idx >= flags.size() || !flags[idx] || required.find(l) != required.end();
+                }),
+                group.end());
+    for (int l : c) flags[DropLitIndex(l)] = 0;
+    if (group.empty() || c.size() < 2) return;
+
+    if (group.size() < c.size()) {
+        for (int l : group) flags[DropLitIndex(l)] = 1;
+        cube temp_c;
+        temp_c.reserve(c.size() - group.size());
+        for (int l : c)
+            if (!flags[DropLitIndex(l)]) temp_c.emplace_back(l);
+        for (int l : group) flags[DropLitIndex(l)] = 0;
+        queries++;
+        if (tryDrop(temp_c, group.size() == 1)) {
+            c.swap(temp_c);
+            return;
+        }
+        if (group.size() == 1) {
+            required.insert(group[0]);
+            return;
+        }
+    }
+    size_t half = group.size() / 2;
+    DropLiterals(c, cube(group.begin(), group.begin() + half), required, tryDrop, queries);
+    DropLiterals(c, cube(group.begin() + half, group.end()), required, tryDrop, queries);
+}
+
+
+// lemma exchange between engines running in one process, a bounded ring of the
+// newest entries, every consumer keeps its own cursor to the next entry to read.
+// a consumer that falls a whole ring behind skips the overwritten entries
+class LemmaBus {
+  public:
+    struct Entry {
+        cube lemma; // sorted by cmp
+        int level;  // frame level the lemma is blocked at by its source
+        int source; // id of the publishing engine
+    };
+
+    LemmaBus(size_t capacity = 1 << 16) : m_capacity(capacity) {}
+    LemmaBus(const LemmaBus &) = delete;
+    LemmaBus &operator=(const LemmaBus &) = delete;
+
+    void Publish(const cube &lemma, int level, int source);
+
+    // copies of the entries published by others from cursor on, oldest first, advances cursor
+    void Collect(uint64_t &cursor, int source, vector<Entry> &entries);
+
+  private:
+    const size_t m_capacity;
+    mutex m_mutex;
+    vector<Entry> m_ring;
+    uint64_t m_published = 0; // entry i is at m_ring[i % m_capacity]
+};
+
 
 class OverSequenceSet {
   public:
     OverSequenceSet(Model &model) : m_model(model) {
         m_invariantLevel = 0;
         m_blockCounter.emplace_back(0);
-        m_insertCounter.emplace_back(0);
         m_tmpLitOffset = m_model.NumVar();
         m_tmpLitFlags.assign(static_cast<size_t>(m_tmpLitOffset * 2 + 1), 0);
     }
@@ -64,10 +294,30 @@ class OverSequenceSet {
 
     bool Insert(const cube &uc, int index);
 
+    void SetLemmaBus(shared_ptr<LemmaBus> bus, int source) {
+        m_lemmaBus = bus;
+        m_lemmaSource = source;
+    }
+
+    // imported lemmas are not published again
+    void SetPublish(bool publish) { m_publish = publish; }
+
+    // keep the lemmas packed as well and check states against them with a bit sweep,
+    // pays off when states assign most of the latches
+    void SetPacked();
+
     shared_ptr<frame> GetFrame(int lvl);
 
     bool IsBlockedByFrame(const cube &latches, int frameLevel);
 
+    bool IsBlockedByFrame(const cube &latches, int frameLevel, BlockerMemo &memo);
+
+    // identical latch cubes share one memo, the stale ones are pruned when there are too many
+    BlockerMemo &GetBlockerMemo(const cube &latches);
+
+    // the states of the memos are gone, e.g. on restart
+    void ClearBlockerMemos() { m_blockerMemos.clear(); }
+
     void GetBlockers(const cube &latches, int framelevel, vector<cube> &b);
 
     bool IsEmpty(int frameLevel) {
@@ -79,10 +329,33 @@ class OverSequenceSet {
 
     string FramesDetail();
 
+    // lemmas erased from the frame so far
+    uint64_t GetErasedCount(int frameLevel) {
+        GetFrame(frameLevel);
+        return m_eraseEpochs[frameLevel];
+    }
+
+    // changes with every lemma inserted into or erased from the frame
+    uint64_t GetFrameVersion(int frameLevel) {
+        GetFrame(frameLevel);
+        return m_frameVersions[frameLevel];
+    }
+
   private:
-    void CleanupImplied(int frameLevel);
+    void Watch(int frameLevel, const cube *uc);
+    void Unwatch(int frameLevel, const cube *uc);
+
+    void EraseSubsumed(int frameLevel, const cube &uc);
 
-    bool Imply(const cube &a, const cube &b);
+    void EraseFromFrame(int frameLevel, const cube *uc);
+
+    void PruneBlockerMemos();
+
+    bool PackCube(const cube &c, uint64_t *out);
+    void PackedInsert(int frameLevel, const cube *uc);
+    void PackedErase(int frameLevel, const cube *uc);
+    const cube *FindBlockerPacked(const cube &latches, int frameLevel);
+    const cube *FindBlocker(const cube &latches, int frameLevel);
 
     void EnsureTmpLitCapacity(const cube &latches);
     void TmpLitSetInsert(int lit);
@@ -91,16 +364,109 @@ class OverSequenceSet {
 
     Model &m_model;
     vector<shared_ptr<frame>> m_sequence;
+    // every lemma once, with the number of frames that hold it,
+    // the keys keep their address until they are erased
+    unordered_map<cube, int, CubeHash> m_lemmaPool;
+    // per frame, every lemma is listed under one of its literals, the empty one under 0,
+    // a lemma that blocks a state is found through the literals of the state
+    vector<unordered_map<int, SignedCubes>> m_watches;
+    // per frame, every lemma is listed under each of its literals
+    vector<unordered_map<int, SignedCubes>> m_occurs;
+    vector<uint32_t> m_tmpIndexes;
+    // position of a variable in GetModelLatches(), -1 for other variables
+    vector<int> m_packPos;
+    size_t m_packWords = 0;
+    vector<PackedCubes> m_packed;
+    vector<uint64_t> m_tmpPacked;
+    // per frame, the number of lemmas erased so far
+    vector<uint64_t> m_eraseEpochs;
+    vector<uint64_t> m_frameVersions;
+    unordered_map<cube, BlockerMemo, CubeHash> m_blockerMemos;
+    static constexpr size_t kMaxBlockerMemos = 1 << 16;
     vector<int> m_blockCounter;
-    vector<int> m_insertCounter;
     int m_invariantLevel;
     vector<uint8_t> m_tmpLitFlags;
     vector<size_t> m_tmpLitList;
     int m_tmpLitOffset = 0;
-    static constexpr int kCleanupThreshold = 128;
+    shared_ptr<LemmaBus> m_lemmaBus;
+    int m_lemmaSource = -1;
+    bool m_publish = true;
 };
 
 
+class UnderSequence;
+
+// O_i is covered by O_0 | ... | O_(i-1), checked on one solver that lives as long as
+// the sequence. every lemma is encoded once, "s is outside O_l" is a clause under an
+// activation literal that is retired and replaced when O_l changes
+class InvariantChecker {
+  public:
+    InvariantChecker(Model &model, shared_ptr<OverSequenceSet> sequence)
+        : m_sequence(sequence),
+          m_solver(make_shared<SATSolver>(model, MCSATSolver::cadical)) {}
+
+    bool Check(int frameLevel);
+
+  private:
+    struct LemmaFlags {
+        int sat;     // -> the state satisfies the lemma cube
+        int blocked; // -> the state does not satisfy the lemma cube
+    };
+
+    const LemmaFlags &GetFlags(const cube &lemma);
+    int GetOutsideLiteral(int frameLevel);
+
+    shared_ptr<OverSequenceSet> m_sequence;
+    shared_ptr<SATSolver> m_solver;
+    unordered_map<cube, LemmaFlags, CubeHash> m_flags;
+    // per level, the activation literal and the frame version it encodes
+    vector<int> m_outside;
+    vector<uint64_t> m_outsideVersions;
+};
+
+
+// a frame solver keeps the clauses of the lemmas erased from its frame,
+// one that carries more of them than live ones is rebuilt from T and the live
+// lemmas on a background thread, the lemmas added meanwhile are replayed on the swap
+class SolverCompactor {
+  public:
+    using CloneFn = function<shared_ptr<SATSolver>(int lvl, const vector<cube> &lemmas)>;
+    using AddFn = function<void(SATSolver &solver, const cube &lemma)>;
+
+    SolverCompactor(shared_ptr<OverSequenceSet> sequence, CloneFn clone, AddFn add)
+        : m_sequence(sequence), m_clone(clone), m_add(add) {}
+
+    // starts a rebuild of the solver of lvl when it is due
+    void LemmaAdded(int lvl, const cube &lemma);
+
+    // swaps the finished rebuilds into solvers, returns their number
+    int Collect(vector<shared_ptr<SATSolver>> &solvers);
+
+  private:
+    static constexpr uint64_t kMinDeadLemmas = 256;
+
+    struct Rebuild {
+        int lvl;
+        uint64_t erased;
+        vector<cube> pending;
+        future<shared_ptr<SATSolver>> solver;
+    };
+
+    shared_ptr<OverSequenceSet> m_sequence;
+    CloneFn m_clone;
+    AddFn m_add;
+    // per level, the erased count of the frame when its solver was built
+    vector<uint64_t> m_builtErased;
+    vector<Rebuild> m_rebuilds;
+};
+
+
+// lemmas are the ones added to a level since its worker solvers were made, a slot is a
+// solver and the number of them it has added. drops the lemmas every solver has added
+// and the ones the frame f has erased since, the slots are moved along
+void CompactLevelLemmas(vector<cube> &lemmas, vector<pair<shared_ptr<SATSolver>, size_t>> &slots, const frame &f);
+
+
 struct State {
     State(shared_ptr<State> inPreState,
           const cube &inInputs,
@@ -110,25 +476,66 @@ struct State {
                          inputs(inInputs),
                          latches(inLatches),
                          dtScore(0) {}
-    static int numInputs;
-    static int numLatches;
-
-    string GetLatchesString();
-    string GetInputsString();
+    string GetLatchesString(int numInputs, int numLatches);
+    string GetInputsString(int numInputs);
 
     int depth;
     shared_ptr<State> preState = nullptr;
     cube inputs;
     cube latches;
     double dtScore;
+    // where the state sits in the score heap of its under sequence
+    UnderSequence *under = nullptr;
+    size_t heapPos = 0;
 
-    void HasUC() {
-        dtScore += 0.7;
-    }
+    inline void HasUC();
 
-    void HasSucc() {
-        dtScore += 0.3;
-    }
+    inline void HasSucc();
+};
+
+
+// free-list pool of equally sized blocks, allocate_shared puts a State and its
+// control block into one block, requests of another size go to operator new
+class StatePool {
+  public:
+    // a shared pool is locked, its states may be released on another thread
+    StatePool(bool shared = false) : m_shared(shared) {}
+    ~StatePool();
+    StatePool(const StatePool &) = delete;
+    StatePool &operator=(const StatePool &) = delete;
+
+    void *Allocate(size_t bytes);
+    void Deallocate(void *p, size_t bytes);
+
+  private:
+    static constexpr size_t kSlabBlocks = 1024;
+
+    const bool m_shared;
+    mutex m_mutex;
+    size_t m_blockSize = 0;
+    void *m_free = nullptr;
+    vector<void *> m_slabs;
+};
+
+
+// the allocators share the pool, it lives until the last state is gone
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator(shared_ptr<StatePool> p) : pool(p) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &other) : pool(other.pool) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(pool->Allocate(n * sizeof(T))); }
+    void deallocate(T *p, size_t n) { pool->Deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &other) const { return pool == other.pool; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &other) const { return pool != other.pool; }
+
+    shared_ptr<StatePool> pool;
 };
 
 
@@ -146,44 +553,69 @@ struct Task {
 
 class UnderSequence {
   public:
-    UnderSequence() {}
+    // capacity 0 keeps every state, sharedPool when a state may be released on another thread
+    UnderSequence(size_t capacity = 0, bool sharedPool = false)
+        : m_capacity(capacity), m_pool(make_shared<StatePool>(sharedPool)) {}
     ~UnderSequence() {
         for (int i = 0; i < m_sequence.size(); ++i) {
             m_sequence.clear();
         }
     }
 
+    shared_ptr<State> NewState(shared_ptr<State> preState, const cube &inputs, const cube &latches, int depth) {
+        return allocate_shared<State>(PoolAllocator<State>(m_pool), preState, inputs, latches, depth);
+    }
+
     void push(shared_ptr<State> state) {
         while (m_sequence.size() <= state->depth) {
             m_sequence.emplace_back(vector<shared_ptr<State>>());
         }
         m_sequence[state->depth].emplace_back(state);
+        state->under = this;
+        state->heapPos = m_heap.size();
+        m_heap.emplace_back(state);
+        SiftUp(state->heapPos);
+        m_count++;
+        if (m_capacity > 0 && m_count > m_capacity) Evict();
     }
 
     int size() { return m_sequence.size(); }
 
-    static bool state_ptr_cmp(shared_ptr<State> s1, shared_ptr<State> s2) {
-        return s1->dtScore > s2->dtScore;
+    // scores only grow, a state moves up the heap when its score changes
+    void Raise(State *s) {
+        if (s->heapPos < m_heap.size() && m_heap[s->heapPos].get() == s) SiftUp(s->heapPos);
     }
 
-    vector<shared_ptr<State>> GetSeqDT() {
-        vector<shared_ptr<State>> res;
-        for (int i = 0; i < m_sequence.size(); ++i) {
-            for (int j = 0; j < m_sequence[i].size(); ++j) {
-                res.emplace_back(m_sequence[i][j]);
-            }
-        }
-        sort(res.begin(), res.end(), state_ptr_cmp);
-        res.resize(res.size() / 5);
-        return res;
-    }
+    // the fifth of the states with the highest scores, best first
+    vector<shared_ptr<State>> GetSeqDT();
 
     vector<shared_ptr<State>> &operator[](int i) { return m_sequence[i]; }
 
   private:
+    void Evict();
+    void SiftUp(size_t pos);
+    void RebuildHeap();
+
     vector<vector<shared_ptr<State>>> m_sequence;
+    // max-heap of the states by dtScore
+    vector<shared_ptr<State>> m_heap;
+    vector<size_t> m_frontier;
+    size_t m_count = 0;
+    size_t m_capacity;
+    shared_ptr<StatePool> m_pool;
 };
 
+
+inline void State::HasUC() {
+    dtScore += 0.7;
+    if (under != nullptr) under->Raise(this);
+}
+
+inline void State::HasSucc() {
+    dtScore += 0.3;
+    if (under != nullptr) under->Raise(this);
+}
+
 struct Luby {
   public:
     Luby() {
@@ -249,7 +681,7 @@ struct Luby {
 
 class Restart {
   public:
-    Restart(Settings settings) {
+    Restart(Settings settings, Log &log) : m_log(log) {
         if (settings.restartLuby) {
             isLubyActived = true;
             m_luby.PushLuby(15);
@@ -260,7 +692,7 @@ class Restart {
     }
 
     bool RestartCheck() {
-        GLOBAL_LOG->L(3, "Restart Check: ", m_ucCounts, " > ", m_threshold);
+        m_log.L(3, "Restart Check: ", m_ucCounts, " > ", m_threshold);
         return m_ucCounts > m_threshold;
     }
 
@@ -270,7 +702,7 @@ class Restart {
         } else {
             m_threshold = m_threshold * m_growthRate;
         }
-        GLOBAL_LOG->L(2, "Updated Restart Threshold: ", m_threshold);
+        m_log.L(2, "Updated Restart Threshold: ", m_threshold);
     }
 
     void UcCountsPlus1() { m_ucCounts++; }
@@ -278,6 +710,7 @@ class Restart {
     void ResetUcCounts() { m_ucCounts = 0; }
 
   private:
+    Log &m_log;
     bool isLubyActived = false;
     int m_threshold;
     int m_baseThreshold;
@@ -1,16 +1,18 @@
 #include "Log.h"
 #include <algorithm>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
 namespace car {
 
+// the interrupted thread may hold LOG_OUTPUT_MUTEX, only async-signal-safe calls here
 void signalHandler(int signum) {
     if (GLOBAL_LOG != nullptr) {
-        GLOBAL_LOG->PrintCustomStatistics();
-        GLOBAL_LOG->L(0, "Unknown");
+        static const char msg[] = "Unknown\n";
+        [[maybe_unused]] ssize_t n = write(STDOUT_FILENO, msg, sizeof(msg) - 1);
     }
-    exit(signum);
+    _exit(signum);
 }
 
 Log::ScopedTimer::ScopedTimer(Log &log, string name)
@@ -46,6 +48,8 @@ Log::ScopedTimer::~ScopedTimer() {
 
 Log *GLOBAL_LOG = nullptr;
 
+mutex LOG_OUTPUT_MUTEX;
+
 
 string CubeToStr(const vector<int> &c) {
     string s;
@@ -111,6 +115,7 @@ void Log::EndSection() {
 
 void Log::PrintCustomStatistics() {
     if (m_verbosity == 0) return;
+    lock_guard<mutex> lock(LOG_OUTPUT_MUTEX);
 
     vector<pair<string, CustomTimeStat>> sorted(m_customStats.begin(), m_customStats.end());
     sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
@@ -137,6 +142,10 @@ void Log::PrintCustomStatistics() {
              << "per: " << fixed << setprecision(6) << 0.0 << endl;
     }
 
+    if (m_genQueries > 0) {
+        cout << "Generalization literals: " << m_genLiterals << "  queries: " << m_genQueries << endl;
+    }
+
     cout << "Total Time     spent: " << fixed << setprecision(2)
          << GetTimeDouble(chrono::duration_cast<std::chrono::microseconds>(
                 chrono::steady_clock::now() - m_begin))
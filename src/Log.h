@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -22,6 +23,9 @@ string CubeToStrShort(const vector<int> &c);
 
 void signalHandler(int signum);
 
+// serializes the output of the logs of concurrently running engines
+extern mutex LOG_OUTPUT_MUTEX;
+
 class Log {
   public:
     struct CustomTimeStat {
@@ -56,6 +60,7 @@ class Log {
         if (messageVerbosity <= m_verbosity) {
             ostringstream oss;
             logHelper(oss, args...);
+            lock_guard<mutex> lock(LOG_OUTPUT_MUTEX);
             cout << oss.str() << endl;
         }
     }
@@ -129,6 +134,12 @@ class Log {
             chrono::steady_clock::now() - m_tick);
     }
 
+    // literals a generalization may drop and the drop queries it took
+    inline void StatGeneralize(int literals, int queries) {
+        m_genLiterals += literals;
+        m_genQueries += queries;
+    }
+
     inline double GetTimeDouble(chrono::microseconds time) {
         return chrono::duration_cast<chrono::duration<double>>(time).count();
     }
@@ -169,6 +180,8 @@ class Log {
     chrono::microseconds m_getNewLevelTime{0};
     uint32_t m_updateUc = 0;
     chrono::microseconds m_updateUcTime{0};
+    uint64_t m_genLiterals = 0;
+    uint64_t m_genQueries = 0;
 
     chrono::microseconds m_initTime{0};
     chrono::microseconds m_internalSignalsTime{0};
@@ -12,7 +12,7 @@ bool ParseSettings(int argc, char **argv, Settings &settings) {
         ->required()
         ->check(CLI::ExistingFile);
 
-    app.add_option("-w", settings.witnessOutputDir, "Witness Output Dir")
+    app.add_option("-w", settings.witnessOutputDir, "Witness Output Dir, not for multiple properties")
         ->check(CLI::ExistingDirectory);
 
     app.add_option("-a", settings.alg, "Model Checking Algorithm")
@@ -21,7 +21,8 @@ bool ParseSettings(int argc, char **argv, Settings &settings) {
                 {"fcar", MCAlgorithm::FCAR},
                 {"bcar", MCAlgorithm::BCAR},
                 {"bmc", MCAlgorithm::BMC},
-                {"ic3", MCAlgorithm::IC3}}))
+                {"ic3", MCAlgorithm::IC3},
+                {"portfolio", MCAlgorithm::Portfolio}}))
         ->default_val("fcar");
 
     app.add_option("-s", settings.solver, "Main SAT Solver")
@@ -40,9 +41,13 @@ bool ParseSettings(int argc, char **argv, Settings &settings) {
     app.add_option("--step", settings.bmc_step, "Performs BMC by unrolling k steps in a single batch")
         ->default_val(1);
 
+    app.add_option("--bmc_threads", settings.bmcThreads, "BMC threads, each one solves windows of --step bounds")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
     app.add_option("--br", settings.branching, "branching # i-good lemma")
         ->default_val(1)
-        ->check(CLI::Range(1, 3));
+        ->check(CLI::Range(1, 4));
 
     app.add_option("--seed", settings.randomSeed, "random seed # i-good lemma")
         ->default_val(0)
@@ -75,7 +80,7 @@ bool ParseSettings(int argc, char **argv, Settings &settings) {
     app.add_option("--ctg_max_states", settings.ctgMaxStates, "CTG max states")
         ->default_val(3);
 
-    app.add_flag("--sd", settings.satSolveInDomain, "solve SAT in domain")
+    app.add_flag("--sd", settings.satSolveInDomain, "solve SAT in domain, on COI slices of T for non-minicore solvers")
         ->default_val(false)
         ->excludes("--is");
 
@@ -88,9 +93,47 @@ bool ParseSettings(int argc, char **argv, Settings &settings) {
     app.add_option("--eq_timeout", settings.eqTimeout, "equivalent variable checking timeout for random simulation (in seconds)")
         ->default_val(600);
 
+    app.add_option("--eq_threads", settings.eqThreads, "threads proving the candidate equivalences of random simulation")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
     app.add_flag("--bp", settings.searchFromBadPred, "search from bad predecessor")
         ->default_val(false);
 
+    app.add_flag("--share", settings.shareLemmas, "share lemmas between the portfolio engines")
+        ->default_val(false);
+
+    app.add_option("--prop_threads", settings.propThreads, "threads for the lemma propagation of CAR")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("--obl_threads", settings.oblThreads, "threads blocking the obligations a CAR frame starts with")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
+    app.add_flag("--async_lift", settings.asyncLift, "lift the predecessors of CAR on a separate thread")
+        ->default_val(false);
+
+    app.add_flag("--gen_dc", settings.genDC, "drop groups of literals in generalization, split the failing ones")
+        ->default_val(false);
+
+    app.add_option("--spec_threads", settings.specThreads, "threads trying the literal drops of generalization speculatively")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
+    app.add_flag("--packed_frames", settings.packedFrames, "check states against the CAR frames as packed latch bitvectors")
+        ->default_val(false);
+
+    app.add_option("--under_cap", settings.underCap, "states kept in the under sequence of CAR, the lowest dt scores go beyond it, 0 for no cap")
+        ->default_val(0)
+        ->check(CLI::NonNegativeNumber);
+
+    app.add_flag("--compact_solvers", settings.compactSolvers, "rebuild the CAR frame solvers that carry many subsumed lemmas in the background")
+        ->default_val(false);
+
+    app.add_flag("--ternary_lift", settings.ternaryLift, "lift predecessors by ternary simulation, SAT lifting when it cannot decide")
+        ->default_val(false);
+
     try {
         app.parse(argc, argv);
         return true;
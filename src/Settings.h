@@ -11,7 +11,8 @@ namespace car {
 enum class MCAlgorithm { FCAR,
                          BCAR,
                          BMC,
-                         IC3 };
+                         IC3,
+                         Portfolio };
 
 enum class MCSATSolver { minisat,
                          cadical,
@@ -42,7 +43,19 @@ struct Settings {
     int bmc_step = 1;
     int eq = 2;
     int eqTimeout = 600;
+    int eqThreads = 1;
     bool searchFromBadPred = false;
+    bool shareLemmas = false;
+    int propThreads = 1;
+    int oblThreads = 1;
+    bool asyncLift = false;
+    bool genDC = false;
+    int specThreads = 1;
+    bool packedFrames = false;
+    int underCap = 0;
+    bool compactSolvers = false;
+    bool ternaryLift = false;
+    int bmcThreads = 1;
 };
 
 bool ParseSettings(int argc, char **argv, Settings &settings);
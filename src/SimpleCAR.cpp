@@ -4,8 +4,10 @@
 #include "BMC.h"
 #include "BasicIC3.h"
 #include "FCAR.h"
+#include "IncrCheckerHelpers.h"
 #include "Log.h"
 #include "Model.h"
+#include "Portfolio.h"
 #include <iostream>
 #include <memory>
 
@@ -24,11 +26,24 @@ static std::unique_ptr<BaseAlg> CreateChecker(
         return std::make_unique<BMC>(settings, aigerModel, log);
     case MCAlgorithm::IC3:
         return std::make_unique<BasicIC3>(settings, aigerModel, log);
+    case MCAlgorithm::Portfolio:
+        return std::make_unique<Portfolio>(settings, aigerModel, log);
     default:
         return nullptr;
     }
 }
 
+static const char *ResultString(CheckResult res) {
+    switch (res) {
+    case CheckResult::Safe:
+        return "Safe";
+    case CheckResult::Unsafe:
+        return "Unsafe";
+    default:
+        return "Unknown";
+    }
+}
+
 SimpleCAR::SimpleCAR(const Settings &settings) : m_settings(settings) {}
 
 SimpleCAR::~SimpleCAR() {
@@ -37,6 +52,7 @@ SimpleCAR::~SimpleCAR() {
 
 bool SimpleCAR::LoadModel() {
     m_log = std::make_unique<Log>(m_settings.verbosity);
+    GLOBAL_LOG = m_log.get();
     [[maybe_unused]] auto initScope = m_log->Section("Model_Init");
     m_model = std::make_unique<Model>(m_settings, *m_log);
     m_checker = CreateChecker(m_settings, *m_model, *m_log);
@@ -45,26 +61,45 @@ bool SimpleCAR::LoadModel() {
 
 CheckResult SimpleCAR::Prove() {
     if (!m_checker) return CheckResult::Unknown;
+    signal(SIGINT, signalHandler);
+
+    CheckResult res;
+    if (m_model->GetNumProperties() > 1) {
+        res = ProveAll();
+    } else {
+        res = m_checker->Run();
+        if (!m_settings.witnessOutputDir.empty())
+            m_checker->Witness();
+    }
 
-    CheckResult res = m_checker->Run();
+    std::cout << ResultString(res) << std::endl;
+    return res;
+}
 
-    if (!m_settings.witnessOutputDir.empty())
-        m_checker->Witness();
+CheckResult SimpleCAR::ProveAll() {
+    // one line per property, then Unsafe if any fails, Unknown if any is open
+    bool unsafe = false;
+    bool unknown = false;
+    auto groups = m_model->GetPropertyGroups();
+    m_log->L(1, m_model->GetNumProperties(), " properties in ", groups.size(), " groups");
+    for (auto &group : groups) {
+        // the importers re-validate every lemma, so one property's lemmas can seed the next
+        auto bus = std::make_shared<LemmaBus>();
+        for (int p : group) {
+            m_model->SetProperty(p);
+            m_checker = CreateChecker(m_settings, *m_model, *m_log);
+            if (m_settings.alg != MCAlgorithm::Portfolio)
+                m_checker->SetLemmaBus(bus, p);
 
-    switch (res) {
-    case CheckResult::Safe:
-        std::cout << "Safe" << std::endl;
-        break;
-    case CheckResult::Unsafe:
-        std::cout << "Unsafe" << std::endl;
-        break;
-    case CheckResult::Unknown:
-        std::cout << "Unknown" << std::endl;
-        break;
-    default:
-        break;
+            CheckResult res = m_checker->Run();
+            std::cout << "b" << p << ": " << ResultString(res) << std::endl;
+            unsafe |= res == CheckResult::Unsafe;
+            unknown |= res == CheckResult::Unknown;
+        }
     }
-    return res;
+    if (unsafe) return CheckResult::Unsafe;
+    if (unknown) return CheckResult::Unknown;
+    return CheckResult::Safe;
 }
 
 } // namespace car
@@ -19,6 +19,9 @@ class SimpleCAR {
     CheckResult Prove();
 
   private:
+    // checks every property of a multi-property model, groups share their lemmas
+    CheckResult ProveAll();
+
     Settings m_settings;
     std::unique_ptr<Log> m_log;
     std::unique_ptr<Model> m_model;
@@ -0,0 +1,71 @@
+#include "WorkerPool.h"
+
+namespace car {
+
+WorkerPool::WorkerPool(int numWorkers) : m_numWorkers(numWorkers < 1 ? 1 : numWorkers) {
+    for (int w = 1; w < m_numWorkers; ++w) {
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this, w);
+    }
+}
+
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_wakeUp.notify_all();
+    for (auto &t : m_threads) t.join();
+}
+
+
+void WorkerPool::ParallelFor(size_t n, const function<void(int, size_t)> &task) {
+    if (n == 0) return;
+    if (m_threads.empty()) {
+        for (size_t i = 0; i < n; ++i) task(0, i);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_task = &task;
+        m_size = n;
+        m_next.store(0);
+        m_busy = m_threads.size();
+        m_generation++;
+    }
+    m_wakeUp.notify_all();
+
+    Drain(0);
+
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+
+void WorkerPool::WorkerLoop(int worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this, seen] { return m_shutdown || m_generation != seen; });
+            if (m_shutdown) return;
+            seen = m_generation;
+        }
+
+        Drain(worker);
+
+        lock_guard<mutex> lock(m_mutex);
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
+
+
+void WorkerPool::Drain(int worker) {
+    for (size_t i = m_next.fetch_add(1); i < m_size; i = m_next.fetch_add(1)) {
+        (*m_task)(worker, i);
+    }
+}
+
+} // namespace car
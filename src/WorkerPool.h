@@ -0,0 +1,51 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace car {
+
+// a fixed set of threads for data-parallel loops,
+// the calling thread takes part in the work as worker 0
+class WorkerPool {
+  public:
+    explicit WorkerPool(int numWorkers);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    int Size() const { return m_numWorkers; }
+
+    // runs task(worker, index) for every index in [0, n), returns when all are done
+    void ParallelFor(size_t n, const function<void(int, size_t)> &task);
+
+  private:
+    void WorkerLoop(int worker);
+
+    void Drain(int worker);
+
+    int m_numWorkers;
+    vector<thread> m_threads;
+    mutex m_mutex;
+    condition_variable m_wakeUp;
+    condition_variable m_done;
+    const function<void(int, size_t)> *m_task = nullptr;
+    size_t m_size = 0;
+    atomic<size_t> m_next{0};
+    int m_busy = 0;
+    uint64_t m_generation = 0;
+    bool m_shutdown = false;
+};
+
+} // namespace car
+
+#endif
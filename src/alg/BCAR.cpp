@@ -10,16 +10,15 @@ BCAR::BCAR(Settings settings,
                        m_model(model),
                        m_log(log),
                        innOrder(model) {
-    State::numInputs = model.GetNumInputs();
-    State::numLatches = model.GetNumLatches();
     m_lastState = nullptr;
-    GLOBAL_LOG = &m_log;
+    m_checkResult = CheckResult::Unknown;
 }
 
 CheckResult BCAR::Run() {
-    signal(SIGINT, signalHandler);
-
-    if (Check(m_model.GetBad()))
+    bool safe = Check(m_model.GetBad());
+    if (IsStopped())
+        m_checkResult = CheckResult::Unknown;
+    else if (safe)
         m_checkResult = CheckResult::Safe;
     else
         m_checkResult = CheckResult::Unsafe;
@@ -69,6 +68,7 @@ bool BCAR::Check(int badId) {
     m_k = 0;
     stack<Task> workingStack;
     while (true) {
+        if (IsStopped()) return false;
         [[maybe_unused]] auto frameScope = m_log.Section("FC_Frame");
         m_minUpdateLevel = m_k + 1;
         if (m_settings.dt) { // Dynamic Traversal
@@ -95,12 +95,16 @@ bool BCAR::Check(int badId) {
             workingStack.emplace(startState, m_k - 1, true);
 
             while (!workingStack.empty()) {
+                if (IsStopped()) return false;
                 [[maybe_unused]] auto taskScope = m_log.Section("FC_Task");
+                if (m_compactor != nullptr && m_compactor->Collect(m_transSolvers) > 0)
+                    m_log.L(2, "Frame Solver Compacted");
                 Task &task = workingStack.top();
 
                 if (m_settings.restart && m_restart->RestartCheck()) {
                     m_log.L(1, "Restarting...");
-                    m_underSequence = UnderSequence();
+                    m_underSequence = UnderSequence(m_settings.underCap);
+                    m_overSequence->ClearBlockerMemos();
                     while (!workingStack.empty()) workingStack.pop();
                     m_restart->UpdateThreshold();
                     m_restart->ResetUcCounts();
@@ -135,7 +139,7 @@ bool BCAR::Check(int badId) {
                     // Solver return SAT, get a new State, then continue
                     m_log.L(2, "Result >>> SAT <<<");
                     auto p = GetInputAndState(task.frameLevel);
-                    shared_ptr<State> newState(new State(task.state, p.first, p.second, task.state->depth + 1));
+                    shared_ptr<State> newState = m_underSequence.NewState(task.state, p.first, p.second, task.state->depth + 1);
                     m_log.L(3, "Get state: ", CubeToStr(newState->latches));
                     m_underSequence.push(newState);
                     if (m_settings.dt) task.state->HasSucc();
@@ -159,11 +163,12 @@ bool BCAR::Check(int badId) {
         }
 
         // inv
-        m_invSolver = make_shared<SATSolver>(m_model, MCSATSolver::cadical);
-        IsInvariant(0);
         for (int i = 0; i < m_k; ++i) {
             // propagation
-            if (i >= m_minUpdateLevel) {
+            if (i >= m_minUpdateLevel && m_workerPool != nullptr &&
+                m_overSequence->GetFrame(i)->size() >= kParallelPropagationThreshold) {
+                PropagateParallel(i);
+            } else if (i >= m_minUpdateLevel) {
                 shared_ptr<frame> fi = m_overSequence->GetFrame(i);
                 shared_ptr<frame> fi_plus_1 = m_overSequence->GetFrame(i + 1);
                 frame::iterator iter;
@@ -198,9 +203,21 @@ bool BCAR::Check(int badId) {
 void BCAR::Init() {
     [[maybe_unused]] auto initScope = m_log.Section("FC_Init");
     m_overSequence = make_shared<OverSequenceSet>(m_model);
-    m_underSequence = UnderSequence();
+    if (m_settings.packedFrames) m_overSequence->SetPacked();
+    m_invChecker = make_shared<InvariantChecker>(m_model, m_overSequence);
+    m_compactor.reset();
+    if (m_settings.compactSolvers) {
+        m_compactor = make_shared<SolverCompactor>(
+            m_overSequence,
+            [this](int lvl, const vector<cube> &lemmas) { return CloneTransSolver(lvl, lemmas); },
+            [this](SATSolver &slv, const cube &uc) {
+                cube puc(uc);
+                GetPrimed(puc);
+                slv.AddUC(puc);
+            });
+    }
+    m_underSequence = UnderSequence(m_settings.underCap);
     m_branching = make_shared<Branching>(m_settings.branching);
-    litOrder.branching = m_branching;
     blockerOrder.branching = m_branching;
 
     // s & T & c & O_i'
@@ -221,7 +238,11 @@ void BCAR::Init() {
     m_badSolver->AddConstraints();
     m_badSolver->AddBad();
 
-    m_restart.reset(new Restart(m_settings));
+    m_restart.reset(new Restart(m_settings, m_log));
+    if (m_settings.propThreads > 1) m_workerPool = make_shared<WorkerPool>(m_settings.propThreads);
+    m_workerSolvers.clear();
+    m_levelLemmas.clear();
+    m_levelErased.clear();
 }
 
 bool BCAR::AddUnsatisfiableCore(const cube &uc, int frameLevel) {
@@ -239,6 +260,14 @@ bool BCAR::AddUnsatisfiableCore(const cube &uc, int frameLevel) {
         if (m_settings.solveInProperty) m_transSolvers.back()->AddProperty();
     }
     m_transSolvers[frameLevel]->AddUC(puc);
+    if (m_compactor != nullptr) m_compactor->LemmaAdded(frameLevel, uc);
+    if (m_workerPool != nullptr) {
+        if (frameLevel >= m_levelLemmas.size()) m_levelLemmas.resize(frameLevel + 1);
+        m_levelLemmas[frameLevel].emplace_back(uc);
+        // a level the workers have not synced for long keeps no more than its frame
+        if (m_levelLemmas[frameLevel].size() > 2 * m_overSequence->GetFrame(frameLevel)->size() + kLevelLemmasSlack)
+            CompactWorkerLemmas(frameLevel);
+    }
 
     if (frameLevel >= m_k) {
         m_startSolver->AddUC(puc, frameLevel);
@@ -333,8 +362,9 @@ void BCAR::OverSequenceRefine(int lvl) {
 int BCAR::GetNewLevel(const cube &states, int start) {
     [[maybe_unused]] auto scoped = m_log.Section("FC_GetNewLevel");
 
+    BlockerMemo &memo = m_overSequence->GetBlockerMemo(states);
     for (int i = start; i <= m_k; i++) {
-        if (!m_overSequence->IsBlockedByFrame(states, i)) {
+        if (!m_overSequence->IsBlockedByFrame(states, i, memo)) {
             return i - 1;
         }
     }
@@ -345,60 +375,10 @@ int BCAR::GetNewLevel(const cube &states, int start) {
 
 bool BCAR::IsInvariant(int frameLevel) {
     [[maybe_unused]] auto invScope = m_log.Section("FC_Invariant");
-    shared_ptr<frame> frame_i = m_overSequence->GetFrame(frameLevel);
-
-    if (frameLevel < m_minUpdateLevel) {
-        AddConstraintOr(frame_i);
-        return false;
-    }
-
-    AddConstraintAnd(frame_i);
-    bool result = false;
-    {
-        [[maybe_unused]] auto satScope = m_log.Section("SAT_BC_Inv");
-        result = !m_invSolver->Solve();
-    }
-    m_invSolver->FlipLastConstrain();
-    AddConstraintOr(frame_i);
-
-    return result;
-}
-
-
-// ================================================================================
-// @brief: add constraint | O_i
-// @input:
-// @output:
-// ================================================================================
-void BCAR::AddConstraintOr(const shared_ptr<frame> f) {
-    cube cls;
-    for (const cube &frame_cube : *f) {
-        int flag = m_invSolver->GetNewVar();
-        cls.push_back(flag);
-        for (int i = 0; i < frame_cube.size(); i++) {
-            m_invSolver->AddClause(cube{-flag, frame_cube[i]});
-        }
-    }
-    m_invSolver->AddClause(cls);
-}
-
+    if (frameLevel < m_minUpdateLevel) return false;
 
-// ================================================================================
-// @brief: add constraint & !O_i
-// @input:
-// @output:
-// ================================================================================
-void BCAR::AddConstraintAnd(const shared_ptr<frame> f) {
-    int flag = m_invSolver->GetNewVar();
-    for (const cube &frame_cube : *f) {
-        cube cls;
-        for (int i = 0; i < frame_cube.size(); i++) {
-            cls.push_back(-frame_cube[i]);
-        }
-        cls.push_back(-flag);
-        m_invSolver->AddClause(cls);
-    }
-    m_invSolver->AddAssumption(cube{flag});
+    [[maybe_unused]] auto satScope = m_log.Section("SAT_BC_Inv");
+    return m_invChecker->Check(frameLevel);
 }
 
 
@@ -422,22 +402,38 @@ bool BCAR::Generalize(cube &uc, int frame_lvl, int rec_lvl) {
 
     if (m_settings.referSkipping)
         for (auto b : uc_blocker) required_lits.emplace(b);
-    vector<cube> failed_ctses;
+    FailedStates failed_ctses;
     OrderAssumption(uc);
-    for (int i = uc.size() - 1; i > 0; i--) {
-        if (required_lits.find(uc[i]) != required_lits.end()) continue;
-        cube temp_uc;
-        temp_uc.reserve(uc.size());
-        for (auto ll : uc)
-            if (ll != uc[i]) temp_uc.emplace_back(ll);
-        if (Down(temp_uc, frame_lvl, rec_lvl, failed_ctses)) {
-            uc.swap(temp_uc);
-            OrderAssumption(uc);
-            i = uc.size();
-        } else {
-            required_lits.emplace(uc[i]);
+    // the first literal of the order is never dropped
+    int literals = 0, queries = 0;
+    for (int i = 1; i < uc.size(); i++)
+        if (required_lits.find(uc[i]) == required_lits.end()) literals++;
+    if (m_settings.genDC) {
+        // a group is tried without ctg, single literals get the usual recursion
+        if (!uc.empty()) required_lits.emplace(uc[0]);
+        auto tryDrop = [&](cube &temp_uc, bool single) {
+            int lvl = single ? rec_lvl : m_settings.ctgMaxRecursionDepth + 1;
+            return Down(temp_uc, frame_lvl, lvl, failed_ctses);
+        };
+        DropLiterals(uc, cube(uc.rbegin(), uc.rend()), required_lits, tryDrop, queries);
+    } else {
+        for (int i = uc.size() - 1; i > 0; i--) {
+            if (required_lits.find(uc[i]) != required_lits.end()) continue;
+            cube temp_uc;
+            temp_uc.reserve(uc.size());
+            for (auto ll : uc)
+                if (ll != uc[i]) temp_uc.emplace_back(ll);
+            queries++;
+            if (Down(temp_uc, frame_lvl, rec_lvl, failed_ctses)) {
+                uc.swap(temp_uc);
+                OrderAssumption(uc);
+                i = uc.size();
+            } else {
+                required_lits.emplace(uc[i]);
+            }
         }
     }
+    m_log.StatGeneralize(literals, queries);
     sort(uc.begin(), uc.end(), cmp);
     if (uc.size() > uc_blocker.size() && frame_lvl != 0) {
         return false;
@@ -446,7 +442,7 @@ bool BCAR::Generalize(cube &uc, int frame_lvl, int rec_lvl) {
 }
 
 
-bool BCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses) {
+bool BCAR::Down(cube &uc, int frame_lvl, int rec_lvl, FailedStates &failed_ctses) {
     [[maybe_unused]] auto downScope = m_log.Section("FC_Dn");
     int ctgs = 0;
     cube assumption(uc);
@@ -486,9 +482,12 @@ bool BCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses
 }
 
 
-bool BCAR::DownHasFailed(const cube &s, const vector<cube> &failed_ctses) {
-    for (auto f : failed_ctses) {
+bool BCAR::DownHasFailed(const cube &s, const FailedStates &failed_ctses) {
+    uint64_t sig = CubeSignature(s);
+    for (size_t i = 0; i < failed_ctses.cubes.size(); ++i) {
         // if f->s , return true
+        if ((failed_ctses.sigs[i] & ~sig) != 0) continue;
+        const cube &f = failed_ctses.cubes[i];
         if (f.size() > s.size()) continue;
         if (includes(s.begin(), s.end(), f.begin(), f.end(), cmp)) return true;
     }
@@ -571,13 +570,8 @@ cube BCAR::GetUnsatCore(int lvl, const cube &state) {
 
 
 cube BCAR::GetUnsatAssumption(shared_ptr<SATSolver> solver, const cube &assumptions) {
-    const unordered_set<int> &conflict = solver->GetConflict();
     cube res;
-
-    for (auto a : assumptions) {
-        if (conflict.find(a) != conflict.end())
-            res.emplace_back(a);
-    }
+    solver->GetFailed(assumptions, false, res);
 
     sort(res.begin(), res.end(), cmp);
     return res;
@@ -614,6 +608,106 @@ bool BCAR::Propagate(const cube &c, int lvl) {
 }
 
 
+// ================================================================================
+// @brief: propagate the cubes of O_i on per-worker copies of the level solver,
+//         the cores are added to O_i+1 in the iteration order of O_i
+// @input:
+// @output:
+// ================================================================================
+void BCAR::PropagateParallel(int lvl) {
+    [[maybe_unused]] auto propScope = m_log.Section("FC_PropPar");
+    const frame &fi = *m_overSequence->GetFrame(lvl);
+    shared_ptr<frame> fi_plus_1 = m_overSequence->GetFrame(lvl + 1);
+    vector<const cube *> todo;
+    for (const cube &uc : fi) {
+        if (fi_plus_1->find(uc) != fi_plus_1->end()) continue; // propagated
+        todo.emplace_back(&uc);
+    }
+
+    // the workers only touch their own solver and slot
+    ReserveWorkerSolvers(lvl);
+    vector<cube> cores(todo.size());
+    vector<uint8_t> blocked(todo.size(), 0);
+    m_workerPool->ParallelFor(todo.size(), [&](int worker, size_t i) {
+        shared_ptr<SATSolver> slv = SyncWorkerSolver(lvl, worker);
+        if (slv->Solve(*todo[i])) return;
+        slv->GetFailed(*todo[i], false, cores[i]);
+        sort(cores[i].begin(), cores[i].end(), cmp);
+        blocked[i] = 1;
+    });
+
+    for (size_t i = 0; i < todo.size(); ++i) {
+        if (!blocked[i]) continue;
+        AddUnsatisfiableCore(cores[i], lvl + 1);
+        m_branching->Update(*todo[i]);
+    }
+}
+
+
+// the main thread makes the slots of the level before the workers sync them,
+// the lemmas the frame has erased since are not replayed
+void BCAR::ReserveWorkerSolvers(int lvl) {
+    size_t size = lvl + 1;
+    if (m_workerSolvers.size() < size)
+        m_workerSolvers.resize(size, vector<pair<shared_ptr<SATSolver>, size_t>>(m_workerPool->Size()));
+    if (m_levelLemmas.size() < size) m_levelLemmas.resize(size);
+    if (m_levelErased.size() < size) m_levelErased.resize(size, 0);
+    if (m_overSequence->GetErasedCount(lvl) != m_levelErased[lvl]) CompactWorkerLemmas(lvl);
+}
+
+
+void BCAR::CompactWorkerLemmas(int lvl) {
+    size_t size = lvl + 1;
+    if (m_workerSolvers.size() < size)
+        m_workerSolvers.resize(size, vector<pair<shared_ptr<SATSolver>, size_t>>(m_workerPool->Size()));
+    if (m_levelErased.size() < size) m_levelErased.resize(size, 0);
+    m_levelErased[lvl] = m_overSequence->GetErasedCount(lvl);
+    CompactLevelLemmas(m_levelLemmas[lvl], m_workerSolvers[lvl], *m_overSequence->GetFrame(lvl));
+}
+
+
+// ================================================================================
+// @brief: the copy of m_transSolvers[lvl] of the worker, made on first use,
+//         then only the lemmas added to the level since are replayed
+// @input:
+// @output:
+// ================================================================================
+shared_ptr<SATSolver> BCAR::SyncWorkerSolver(int lvl, int worker) {
+    auto &slot = m_workerSolvers[lvl][worker];
+    const vector<cube> &lemmas = m_levelLemmas[lvl];
+    if (slot.first == nullptr) {
+        slot.first = CloneTransSolver(lvl, *m_overSequence->GetFrame(lvl));
+        slot.second = lemmas.size();
+    }
+    for (; slot.second < lemmas.size(); ++slot.second) {
+        cube puc(lemmas[slot.second]);
+        GetPrimed(puc);
+        slot.first->AddUC(puc);
+    }
+    return slot.first;
+}
+
+
+// ================================================================================
+// @brief: a fresh solver equal to m_transSolvers[lvl], s & T & c & O_i'
+// @input:
+// @output:
+// ================================================================================
+template <typename Lemmas>
+shared_ptr<SATSolver> BCAR::CloneTransSolver(int lvl, const Lemmas &lemmas) {
+    auto slv = make_shared<SATSolver>(m_model, m_settings.solver);
+    slv->AddTrans();
+    slv->AddConstraints();
+    if (lvl > 0 && m_settings.solveInProperty) slv->AddProperty();
+    for (const cube &uc : lemmas) {
+        cube puc(uc);
+        GetPrimed(puc);
+        slv->AddUC(puc);
+    }
+    return slv;
+}
+
+
 int BCAR::PropagateUp(const cube &c, int lvl) {
     while (lvl < m_k) {
         if (Propagate(c, lvl))
@@ -803,13 +897,13 @@ void BCAR::OutputCounterExample(int bad) {
         assert(sat);
         auto p = m_startSolver->GetAssignment(false);
         shared_ptr<State> initState(new State(nullptr, p.first, p.second, 0));
-        cexFile << initState->GetLatchesString() << endl;
+        cexFile << initState->GetLatchesString(m_model.GetNumInputs(), m_model.GetNumLatches()) << endl;
     } else {
-        cexFile << trace.top()->GetLatchesString() << endl;
+        cexFile << trace.top()->GetLatchesString(m_model.GetNumInputs(), m_model.GetNumLatches()) << endl;
     }
 
     while (!trace.empty()) {
-        cexFile << trace.top()->GetInputsString() << endl;
+        cexFile << trace.top()->GetInputsString(m_model.GetNumInputs()) << endl;
         trace.pop();
     }
     cexFile << "." << endl;
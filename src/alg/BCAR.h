@@ -5,6 +5,7 @@
 #include "IncrCheckerHelpers.h"
 #include "Log.h"
 #include "SATSolver.h"
+#include "WorkerPool.h"
 #include "random"
 #include <algorithm>
 #include <assert.h>
@@ -35,16 +36,6 @@ class BCAR : public BaseAlg {
 
     bool IsInvariant(int frameLevel);
 
-    struct LitOrder {
-        shared_ptr<Branching> branching;
-
-        LitOrder() {}
-
-        bool operator()(const int &l1, const int &l2) const {
-            return (branching->PriorityOf(l1) > branching->PriorityOf(l2));
-        }
-    } litOrder;
-
     struct InnOrder {
         Model &m;
 
@@ -80,7 +71,7 @@ class BCAR : public BaseAlg {
             return;
         }
         if (m_settings.branching == 0) return;
-        stable_sort(uc.begin(), uc.end(), litOrder);
+        m_branching->Order(uc);
         if (m_settings.internalSignals) {
             stable_sort(uc.begin(), uc.end(), innOrder);
         }
@@ -94,12 +85,23 @@ class BCAR : public BaseAlg {
 
     bool Generalize(cube &uc, int frame_lvl, int rec_lvl = 1);
 
-    bool Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses);
+    bool Down(cube &uc, int frame_lvl, int rec_lvl, FailedStates &failed_ctses);
 
-    bool DownHasFailed(const cube &s, const vector<cube> &failed_ctses);
+    bool DownHasFailed(const cube &s, const FailedStates &failed_ctses);
 
     bool Propagate(const cube &c, int lvl);
 
+    void PropagateParallel(int lvl);
+
+    void ReserveWorkerSolvers(int lvl);
+
+    void CompactWorkerLemmas(int lvl);
+
+    shared_ptr<SATSolver> SyncWorkerSolver(int lvl, int worker);
+
+    template <typename Lemmas>
+    shared_ptr<SATSolver> CloneTransSolver(int lvl, const Lemmas &lemmas);
+
     int PropagateUp(const cube &c, int lvl);
 
     void OutputWitness(int bad);
@@ -110,10 +112,6 @@ class BCAR : public BaseAlg {
 
     bool CheckBad(shared_ptr<State> s);
 
-    void AddConstraintOr(const shared_ptr<frame> f);
-
-    void AddConstraintAnd(const shared_ptr<frame> f);
-
     bool IsReachable(int lvl, const cube &assumption, const string &label);
 
     pair<cube, cube> GetInputAndState(int lvl);
@@ -135,13 +133,22 @@ class BCAR : public BaseAlg {
     Settings m_settings;
     Log &m_log;
     Model &m_model;
-    vector<shared_ptr<SATSolver>> m_transSolvers;
+    vector<shared_ptr<SATSolver>> m_transSolvers;
+    shared_ptr<SolverCompactor> m_compactor;
     shared_ptr<SATSolver> m_startSolver;
     shared_ptr<SATSolver> m_badSolver;
-    shared_ptr<SATSolver> m_invSolver;
+    shared_ptr<InvariantChecker> m_invChecker;
     vector<shared_ptr<vector<int>>> m_rotation;
     shared_ptr<State> m_lastState;
     std::shared_ptr<Restart> m_restart;
+    shared_ptr<WorkerPool> m_workerPool;
+    static constexpr int kParallelPropagationThreshold = 256;
+    // per level and worker a copy of m_transSolvers[lvl] and the number of
+    // lemmas of m_levelLemmas[lvl] it holds
+    vector<vector<pair<shared_ptr<SATSolver>, size_t>>> m_workerSolvers;
+    vector<vector<cube>> m_levelLemmas;
+    vector<uint64_t> m_levelErased; // erased count of the frame at the last compaction
+    static constexpr size_t kLevelLemmasSlack = 64;
 };
 
 } // namespace car
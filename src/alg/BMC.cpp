@@ -1,4 +1,8 @@
 #include "BMC.h"
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace car {
 
@@ -7,9 +11,6 @@ BMC::BMC(Settings settings,
          Log &log) : m_settings(settings),
                      m_model(model),
                      m_log(log) {
-    State::numInputs = model.GetNumInputs();
-    State::numLatches = model.GetNumLatches();
-    GLOBAL_LOG = &m_log;
     m_k = 0;
     m_maxK = m_settings.bmcK;
     m_checkResult = CheckResult::Unknown;
@@ -19,15 +20,18 @@ BMC::BMC(Settings settings,
 
 
 CheckResult BMC::Run() {
-    signal(SIGINT, signalHandler);
     if (m_settings.solver == MCSATSolver::kissat) {
         if (Check_nonincremental(m_model.GetBad())) {
             m_checkResult = CheckResult::Unsafe;
         }
+    } else if (m_settings.bmcThreads > 1) {
+        if (CheckParallel(m_model.GetBad()))
+            m_checkResult = CheckResult::Unsafe;
     } else {
         if (Check(m_model.GetBad()))
             m_checkResult = CheckResult::Unsafe;
     }
+    if (IsStopped()) m_checkResult = CheckResult::Unknown;
 
     m_log.PrintCustomStatistics();
 
@@ -46,6 +50,7 @@ bool BMC::Check(int badId) {
     Init(badId);
 
     while (true) {
+        if (IsStopped()) return false;
         m_log.L(1, "BMC Bound: ", m_k);
 
         vector<clause> clauses;
@@ -102,6 +107,7 @@ bool BMC::Check_nonincremental(int badId) {
     badClause.reserve(m_step);
     // Pre-allocate m_step memory
     while (true) {
+        if (IsStopped()) return false;
         Init(badId);
         // add clauses before K unrollings to the Kissat solver
         {
@@ -172,13 +178,211 @@ bool BMC::Check_nonincremental(int badId) {
 void BMC::Init(int badId) {
     [[maybe_unused]] auto initScope = m_log.Section("BMC_Init");
     m_badId = badId;
-    m_Solver = make_shared<SATSolver>(m_model, m_settings.solver);
+    m_Solver = NewUnrollingSolver();
+}
+
+
+shared_ptr<SATSolver> BMC::NewUnrollingSolver() {
+    shared_ptr<SATSolver> solver = make_shared<SATSolver>(m_model, m_settings.solver);
 
     // send initial state
     for (auto l : m_model.GetInitialState()) {
-        m_Solver->AddClause({l});
+        solver->AddClause({l});
+    }
+    solver->AddInitialClauses();
+    return solver;
+}
+
+
+// ================================================================================
+// @brief: bound windows [w * step, (w + 1) * step) are taken in order by the workers,
+//         each worker keeps one solver and unrolls it further for every window it gets.
+//         a SAT window is only reported when all the windows below it are UNSAT,
+//         so the counterexample is the shallowest one. the bounds below the first
+//         open window are proven, every worker asserts their !bad like Check does
+// @input:
+// @output: a counterexample is found
+// ================================================================================
+bool BMC::CheckParallel(int badId) {
+    [[maybe_unused]] auto checkScope = m_log.Section("BMC_CheckPar");
+    m_badId = badId;
+    int numWorkers = m_settings.bmcThreads;
+    int step = max(m_step, 1);
+
+    mutex resultMutex;
+    condition_variable resultCv;
+    vector<int> windowResults; // -2 open, -1 UNSAT, else the depth of the cex
+    vector<int> windowWorkers;
+    int firstOpen = 0; // the windows below are UNSAT
+    atomic<int> nextWindow(0);
+    atomic<int> lowestSat(INT_MAX);
+    atomic<int> provenBound(0);
+    atomic<bool> finished(false);
+
+    // the solvers exist before the workers start, so the losers can be interrupted
+    m_model.SetSharedUnrolling();
+    vector<Unrolling> unrollings(numWorkers);
+    for (auto &u : unrollings) u.solver = NewUnrollingSolver();
+
+    auto work = [&](int worker) {
+        while (!finished.load() && !IsStopped()) {
+            int win = nextWindow.fetch_add(1);
+            int lo = win * step;
+            int hi = lo + step - 1;
+            if (m_maxK != -1) {
+                if (lo > m_maxK) break;
+                hi = min(hi, m_maxK);
+            }
+            if (win > lowestSat.load()) break;
+
+            int res = SolveWindow(unrollings[worker], lo, hi, provenBound.load());
+            if (res == -2) break; // interrupted, the window stays open
+            m_log.L(1, "BMC Window: [", lo, ", ", hi, "] ", res < 0 ? "UNSAT" : "SAT");
+
+            {
+                lock_guard<mutex> lock(resultMutex);
+                if (win >= windowResults.size()) {
+                    windowResults.resize(win + 1, -2);
+                    windowWorkers.resize(win + 1, -1);
+                }
+                windowResults[win] = res;
+                windowWorkers[win] = worker;
+                while (firstOpen < windowResults.size() && windowResults[firstOpen] == -1) firstOpen++;
+                provenBound.store(firstOpen * step);
+            }
+            resultCv.notify_one();
+            if (res >= 0) {
+                // keep the model of this solver for the counterexample
+                int expected = lowestSat.load();
+                while (win < expected && !lowestSat.compare_exchange_weak(expected, win)) {
+                }
+                break;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (int w = 0; w < numWorkers; ++w) threads.emplace_back(work, w);
+
+    int cexWindow = -1;
+    {
+        unique_lock<mutex> lock(resultMutex);
+        while (true) {
+            if (firstOpen < windowResults.size() && windowResults[firstOpen] >= 0) {
+                cexWindow = firstOpen;
+                break;
+            }
+            if (m_maxK != -1 && firstOpen * step > m_maxK) break;
+            if (IsStopped()) break;
+            resultCv.wait_for(lock, chrono::milliseconds(100));
+        }
+    }
+    finished.store(true);
+    // a deeper window may be stuck in a hard SAT call, it cannot hold back the counterexample
+    for (auto &u : unrollings) {
+        lock_guard<mutex> lock(u.solveMutex);
+        u.interrupted = true;
+        if (u.solving) u.solver->Interrupt();
+    }
+    for (auto &t : threads) t.join();
+
+    if (cexWindow < 0) return false;
+    m_k = windowResults[cexWindow];
+    m_Solver = unrollings[windowWorkers[cexWindow]].solver;
+    return true;
+}
+
+
+// ================================================================================
+// @brief: unroll the solver up to hi and check bad in [lo, hi],
+//         e_j -> bad^j & p_j, p_j <-> cons^j & p_j-1 chains the constraints of
+//         the window, with an activated clause a -> e_lo | ... | e_hi
+// @input: the unrolling of the worker, all the bounds below proven are UNSAT
+// @output: the shallowest depth of a counterexample in the window, -1 if there
+//          is none, -2 if the window was interrupted
+// ================================================================================
+int BMC::SolveWindow(Unrolling &u, int lo, int hi, int proven) {
+    if (u.solver == nullptr) u.solver = NewUnrollingSolver();
+    shared_ptr<SATSolver> &solver = u.solver;
+
+    for (; u.depth <= hi; ++u.depth) {
+        vector<clause> clauses;
+        GetClausesK(u.depth, clauses);
+        for (auto &cls : clauses) solver->AddClause(cls);
+    }
+    // a cex at or beyond lo satisfies the constraints of all the steps before it
+    for (; u.consDepth < lo; ++u.consDepth) {
+        for (auto c : GetConstraintsK(u.consDepth)) solver->AddClause({c});
+    }
+    for (; u.badDepth < min(lo, proven); ++u.badDepth) solver->AddClause({-GetBadK(u.badDepth)});
+
+    cube selectors;
+    clause window;
+    int act = m_model.GetNewAuxiliaryId();
+    window.emplace_back(-act);
+    cube prefixes;
+    for (int j = lo; j <= hi; ++j) {
+        int e = m_model.GetNewAuxiliaryId();
+        selectors.emplace_back(e);
+        window.emplace_back(e);
+        solver->AddClause({-e, GetBadK(j)});
+        cube cons = GetConstraintsK(j);
+        if (cons.empty()) continue;
+        int p = m_model.GetNewAuxiliaryId();
+        clause def{p};
+        for (auto c : cons) {
+            solver->AddClause({-p, c});
+            def.emplace_back(-c);
+        }
+        if (!prefixes.empty()) {
+            solver->AddClause({-p, prefixes.back()});
+            def.emplace_back(-prefixes.back());
+        }
+        solver->AddClause(def);
+        solver->AddClause({-e, p});
+        prefixes.emplace_back(p);
+    }
+    solver->AddClause(window);
+
+    bool sat;
+    if (!SolveUnrolling(u, {act}, sat)) return -2;
+    if (!sat) {
+        solver->AddClause({-act});
+        // no bound of the window is reached on top of the steps before lo
+        for (int j = lo; j <= hi; ++j) {
+            if (prefixes.empty())
+                solver->AddClause({-GetBadK(j)});
+            else
+                solver->AddClause({-GetBadK(j), -prefixes[j - lo]});
+        }
+        return -1;
+    }
+    for (int j = lo; j < hi; ++j) {
+        if (!SolveUnrolling(u, {selectors[j - lo]}, sat)) return -2;
+        if (sat) return j;
+    }
+    // the window is SAT and none of the shallower selectors is
+    if (!SolveUnrolling(u, {selectors.back()}, sat)) return -2;
+    assert(sat);
+    return hi;
+}
+
+
+// ================================================================================
+// @brief: solve on a worker unrolling that CheckParallel may interrupt
+// @input:
+// @output: false if the solve was interrupted or not started, sat is undefined then
+// ================================================================================
+bool BMC::SolveUnrolling(Unrolling &u, const cube &assumption, bool &sat) {
+    {
+        lock_guard<mutex> lock(u.solveMutex);
+        if (u.interrupted) return false;
+        u.solving = true;
     }
-    m_Solver->AddInitialClauses();
+    sat = u.solver->Solve(assumption);
+    lock_guard<mutex> lock(u.solveMutex);
+    u.solving = false;
+    return !u.interrupted;
 }
 
 
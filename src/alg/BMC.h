@@ -20,6 +20,20 @@ class BMC : public BaseAlg {
   private:
     bool Check(int badId);
     bool Check_nonincremental(int badId);
+    bool CheckParallel(int badId);
+
+    struct Unrolling {
+        shared_ptr<SATSolver> solver;
+        int depth = 0;     // first step whose transition is not in the solver yet
+        int consDepth = 0; // first step whose constraints are not asserted yet
+        int badDepth = 0;  // first step whose !bad is not asserted yet
+        // taken when a solve starts or ends, so Interrupt only hits a solve in progress
+        mutex solveMutex;
+        bool solving = false;
+        bool interrupted = false;
+    };
+    int SolveWindow(Unrolling &u, int lo, int hi, int proven);
+    bool SolveUnrolling(Unrolling &u, const cube &assumption, bool &sat);
     Settings m_settings;
     Log &m_log;
     Model &m_model;
@@ -35,6 +49,7 @@ class BMC : public BaseAlg {
 
     CheckResult m_checkResult;
     void Init(int badId);
+    shared_ptr<SATSolver> NewUnrollingSolver();
     void OutputCounterExample(int bad);
     void GetClausesK(int m_k, vector<clause> &clauses);
     int GetBadK(int m_k);
@@ -3,9 +3,13 @@
 
 #include "Model.h"
 #include "Settings.h"
+#include <atomic>
+#include <memory>
 
 namespace car {
 
+class LemmaBus;
+
 enum class CheckResult { Safe,
                          Unsafe,
                          Unknown };
@@ -15,6 +19,26 @@ class BaseAlg {
     virtual CheckResult Run() = 0;
     virtual void Witness() = 0;
     virtual ~BaseAlg() = default;
+
+    // cooperative cancellation, the engines poll it at safe points and give up with Unknown
+    void SetStopFlag(const std::atomic<bool> *stop) { m_stop = stop; }
+
+    // lemmas are exchanged with the peer engines through the bus, engines without support ignore it
+    void SetLemmaBus(std::shared_ptr<LemmaBus> bus, int source) {
+        m_lemmaBus = bus;
+        m_lemmaSource = source;
+    }
+
+  protected:
+    inline bool IsStopped() const {
+        return m_stop != nullptr && m_stop->load(std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<LemmaBus> m_lemmaBus;
+    int m_lemmaSource = -1;
+
+  private:
+    const std::atomic<bool> *m_stop = nullptr;
 };
 
 } // namespace car
@@ -11,14 +11,13 @@ BasicIC3::BasicIC3(Settings settings,
                    Log &log) : m_settings(settings),
                                m_log(log),
                                m_model(model) {
-    State::numInputs = model.GetNumInputs();
-    State::numLatches = model.GetNumLatches();
     m_cexStart = nullptr;
 
     // Initialize the dedicated solver for predecessor generalization (lifting).
     m_liftSolver = make_shared<SATSolver>(m_model, m_settings.solver);
     if (m_settings.satSolveInDomain) m_liftSolver->SetSolveInDomain();
     m_liftSolver->AddTrans();
+    if (m_settings.ternaryLift) m_ternaryLifter = make_shared<TernaryLifter>(m_model.GetCircuitGraph());
     // set permanent domain
     if (m_settings.satSolveInDomain)
         m_liftSolver->SetDomainCOI(m_model.GetConstraints());
@@ -42,26 +41,25 @@ BasicIC3::BasicIC3(Settings settings,
     m_initialStateSet.insert(initState.begin(), initState.end());
     m_log.L(1, "BasicIC3 checker initialized.");
 
-    GLOBAL_LOG = &m_log;
     m_checkResult = CheckResult::Unknown;
     m_k = 0;
     m_invariantLevel = 0;
     lemmaCount = 0;
 
     m_branching = make_shared<Branching>(m_settings.branching);
-    litOrder.branching = m_branching;
     blockerOrder.branching = m_branching;
 
-    m_settings.satSolveInDomain = m_settings.satSolveInDomain && m_settings.solver == MCSATSolver::minicore;
+    if (m_settings.specThreads > 1) m_specPool = make_shared<WorkerPool>(m_settings.specThreads);
 }
 
 BasicIC3::~BasicIC3() {
 }
 
 CheckResult BasicIC3::Run() {
-    signal(SIGINT, signalHandler);
-
-    if (Check(m_model.GetBad()))
+    bool safe = Check(m_model.GetBad());
+    if (IsStopped())
+        m_checkResult = CheckResult::Unknown;
+    else if (safe)
         m_checkResult = CheckResult::Safe;
     else
         m_checkResult = CheckResult::Unsafe;
@@ -120,6 +118,7 @@ bool BasicIC3::Check(int badId) {
 
     // The main IC3 loop.
     for (m_k = 1;; ++m_k) {
+        if (IsStopped()) return false;
         m_log.L(1, "==================== k=", m_k, " ====================");
         Extend();
         m_log.L(1, FramesInfo());
@@ -219,6 +218,7 @@ void BasicIC3::AddBlockingCube(const cube &blockingCube, int frameLevel, bool to
     }
 
     m_earliest = min(m_earliest, frameLevel);
+    if (m_specPool != nullptr) m_lemmaLog.push_back({blockingCube, frameLevel, toAll});
     if (toAll) {
         lemmaCount++;
         m_log.L(2, "Frame ", frameLevel, ": ", CubeToStr(blockingCube));
@@ -241,27 +241,38 @@ void BasicIC3::AddBlockingCube(const cube &blockingCube, int frameLevel, bool to
     if (frameLevel >= m_k) {
         m_startSolver->AddClause(lemma);
     }
+    if (m_lemmaBus != nullptr && !m_importing) {
+        m_lemmaBus->Publish(blockingCube, frameLevel, m_lemmaSource);
+    }
+}
+
+// Lemmas of the peer engines are revalidated before they are blocked at F_i:
+// they must exclude the initial states and F_{i-1} & T & c' must be unsat.
+void BasicIC3::ImportLemmas() {
+    if (m_lemmaBus == nullptr) return;
+    vector<LemmaBus::Entry> entries;
+    m_lemmaBus->Collect(m_busCursor, m_lemmaSource, entries);
+    if (entries.empty()) return;
+
+    int imported = 0;
+    m_importing = true;
+    for (auto &e : entries) {
+        int lvl = min(e.level, m_k);
+        if (m_frames[lvl].borderCubes.count(e.lemma)) continue;
+        if (!InitiationCheck(e.lemma)) continue;
+        if (!UnreachabilityCheck(e.lemma, m_frames[lvl - 1].solver)) continue;
+        cube core = GetAndValidateCore(m_frames[lvl - 1].solver, e.lemma);
+        AddBlockingCube(core, lvl, true);
+        imported++;
+    }
+    m_importing = false;
+    m_log.L(2, "Imported ", imported, " of ", entries.size(), " lemmas");
 }
 
 cube BasicIC3::GetCore(const shared_ptr<SATSolver> &solver, const cube &fallbackCube, bool prime) {
-    unordered_set<int> conflictSet = solver->GetConflict();
     cube core;
-    if (!prime) {
-        for (const auto &lit : fallbackCube) {
-            if (conflictSet.count(lit)) {
-                core.push_back(lit);
-            }
-        }
-        return core;
-    } else {
-        for (const auto &lit : fallbackCube) {
-            int lit_p = m_model.GetPrimeK(lit, 1);
-            if (conflictSet.count(lit_p)) {
-                core.push_back(lit);
-            }
-        }
-        return core;
-    }
+    solver->GetFailed(fallbackCube, prime, core);
+    return core;
 }
 
 shared_ptr<State> BasicIC3::EnumerateStartState() {
@@ -323,6 +334,7 @@ bool BasicIC3::Strengthen() {
     m_earliest = m_k + 1;
 
     while (true) {
+        ImportLemmas();
         shared_ptr<State> startState = EnumerateStartState();
         if (startState != nullptr) {
             set<Obligation> obligations;
@@ -340,6 +352,7 @@ bool BasicIC3::Strengthen() {
 
 bool BasicIC3::HandleObligations(set<Obligation> &obligations) {
     while (!obligations.empty()) {
+        if (IsStopped()) return false;
         Obligation ob = *obligations.begin();
 
         // Query: F_{ob.level} & T & cti'
@@ -400,7 +413,8 @@ bool BasicIC3::InductionCheck(const cube &cb, const shared_ptr<SATSolver> &slv)
     return result;
 }
 
-bool BasicIC3::Down(cube &downCube, int frameLvl, int recLvl, const set<int> &triedLits) {
+bool BasicIC3::Down(cube &downCube, int frameLvl, int recLvl, const set<int> &triedLits,
+                    const pair<cube, cube> *ctg) {
     m_log.L(3, "Down: ", CubeToStr(downCube), " at frame level ", frameLvl, " and recursion level ", recLvl);
     int ctgs = 0;
     int joins = 0;
@@ -421,17 +435,19 @@ bool BasicIC3::Down(cube &downCube, int frameLvl, int recLvl, const set<int> &tr
 
     while (true) {
         m_log.L(3, "Down attempt: ", CubeToStr(downCube));
-        if (!InitiationCheck(downCube)) {
+        // A speculative drop hands in the CTG it found, both checks are known to fail then.
+        if (ctg == nullptr && !InitiationCheck(downCube)) {
             return false;
         }
-        if (InductionCheck(downCube, solverLvl)) {
+        if (ctg == nullptr && InductionCheck(downCube, solverLvl)) {
             cube downCore = GetAndValidateCore(solverLvl, downCube);
             downCube.swap(downCore);
             return true;
         }
 
         shared_ptr<State> downState = make_shared<State>(nullptr, cube(), downCube, 0);
-        pair<cube, cube> ctgAssignment = solverLvl->GetAssignment(false);
+        pair<cube, cube> ctgAssignment = ctg != nullptr ? *ctg : solverLvl->GetAssignment(false);
+        ctg = nullptr;
         auto ctgState = make_shared<State>(
             downState,
             ctgAssignment.first,
@@ -521,38 +537,76 @@ bool BasicIC3::MIC(cube &cb, int frameLvl, int recLvl) {
     size_t attempts = maxMicAttempts;
 
     OrderAssumption(cb);
-    // Iterate backwards to handle the shrinking cube size gracefully.
-    for (int i = cb.size() - 1; i >= 0; --i) {
-        if (cb.size() < 2) break;
-        int litToDrop = cb[i];
-
-        // If we have already tried and failed to drop this literal, skip.
-        if (triedLits.count(litToDrop)) {
-            continue;
-        }
-
-        // Create a temporary cube with one literal removed.
-        cube dropCube;
-        dropCube.reserve(cb.size() - 1);
-        for (int j = 0; j < cb.size(); ++j) {
-            if (i == j) continue;
-            dropCube.push_back(cb[j]);
-        }
-
-        if (Down(dropCube, frameLvl, recLvl, triedLits)) {
-            // dropCube is sorted
-            cb.swap(dropCube);
-            OrderAssumption(cb);
-            i = cb.size();
-            attempts = maxMicAttempts;
-        } else {
-            if (--attempts == 0) {
-                m_log.L(3, "Max MIC attempts reached, stopping generalization.");
-                break;
+    int literals = 0, queries = 0;
+    for (auto l : cb)
+        if (!triedLits.count(l)) literals++;
+    if (m_settings.genDC) {
+        // Groups are checked without CTGs, single literals get the usual recursion.
+        // The attempt limit of the linear loop does not apply.
+        auto tryDrop = [&](cube &dropCube, bool single) {
+            int lvl = single ? recLvl : m_settings.ctgMaxRecursionDepth + 1;
+            return Down(dropCube, frameLvl, lvl, triedLits);
+        };
+        DropLiterals(cb, cube(cb.rbegin(), cb.rend()), triedLits, tryDrop, queries);
+    } else {
+        // The literals from specFloor on were tried speculatively already.
+        bool speculate = m_specPool != nullptr && frameLvl > 0;
+        int specFloor = cb.size();
+        // Iterate backwards to handle the shrinking cube size gracefully.
+        for (int i = cb.size() - 1; i >= 0; --i) {
+            if (cb.size() < 2) break;
+            int litToDrop = cb[i];
+
+            // If we have already tried and failed to drop this literal, skip.
+            if (triedLits.count(litToDrop)) {
+                continue;
+            }
+
+            if (speculate && i < specFloor) {
+                size_t tried = triedLits.size();
+                bool shrunk = SpeculateDrops(cb, i, frameLvl, recLvl, triedLits, attempts, queries, specFloor);
+                size_t failed = triedLits.size() - tried;
+                if (failed >= attempts) {
+                    m_log.L(3, "Max MIC attempts reached, stopping generalization.");
+                    break;
+                }
+                attempts -= failed;
+                if (shrunk) {
+                    OrderAssumption(cb);
+                    i = cb.size();
+                    specFloor = cb.size();
+                    attempts = maxMicAttempts;
+                    continue;
+                }
+                if (triedLits.count(litToDrop)) continue;
+            }
+
+            // Create a temporary cube with one literal removed.
+            cube dropCube;
+            dropCube.reserve(cb.size() - 1);
+            for (int j = 0; j < cb.size(); ++j) {
+                if (i == j) continue;
+                dropCube.push_back(cb[j]);
+            }
+
+            queries++;
+            if (Down(dropCube, frameLvl, recLvl, triedLits)) {
+                // dropCube is sorted
+                cb.swap(dropCube);
+                OrderAssumption(cb);
+                i = cb.size();
+                specFloor = cb.size();
+                attempts = maxMicAttempts;
+            } else {
+                if (--attempts == 0) {
+                    m_log.L(3, "Max MIC attempts reached, stopping generalization.");
+                    break;
+                }
+                triedLits.insert(litToDrop);
             }
-            triedLits.insert(litToDrop);
         }
     }
+    m_log.StatGeneralize(literals, queries);
     sort(cb.begin(), cb.end(), cmp);
     if (cb.size() > blocker.size() && frameLvl != 0) {
         return false;
@@ -562,9 +616,144 @@ bool BasicIC3::MIC(cube &cb, int frameLvl, int recLvl) {
 }
 
 
+// The drops of cb[i], cb[i-1], ... are checked at once on copies of the frame solver.
+// The first relatively inductive one in the order of the MIC loop is taken and the
+// later ones are not started any more. With CTGs, the failed drops before it go
+// through Down in order, on the CTGs the workers found, and at most attempts of
+// them fail. floor is set to the last index of the batch.
+bool BasicIC3::SpeculateDrops(cube &cb, int i, int frameLvl, int recLvl, set<int> &triedLits,
+                              size_t attempts, int &queries, int &floor) {
+    cube lits;
+    int last = i;
+    for (int j = i; j >= 0 && lits.size() < m_specPool->Size(); --j) {
+        if (triedLits.count(cb[j])) continue;
+        lits.push_back(cb[j]);
+        last = j;
+    }
+    if (lits.size() < 2) return false;
+    floor = last;
+
+    // Drops that intersect the initial states fail in Down as well.
+    vector<cube> dropCubes(lits.size());
+    vector<cube> assumptions(lits.size());
+    vector<uint8_t> initiation(lits.size());
+    for (size_t k = 0; k < lits.size(); ++k) {
+        for (const auto &lit : cb) {
+            if (lit != lits[k]) dropCubes[k].push_back(lit);
+        }
+        initiation[k] = InitiationCheck(dropCubes[k]);
+        assumptions[k] = dropCubes[k];
+        OrderAssumption(assumptions[k]);
+        GetPrimed(assumptions[k]);
+    }
+    if (m_specSolvers.size() < m_frames.size()) {
+        m_specSolvers.resize(m_frames.size(), vector<pair<shared_ptr<SATSolver>, size_t>>(m_specPool->Size()));
+    }
+    bool useCtg = recLvl <= m_settings.ctgMaxRecursionDepth;
+    size_t logged = m_lemmaLog.size();
+
+    // The workers only touch their own solver and slot.
+    vector<cube> cores(lits.size());
+    vector<pair<cube, cube>> ctgs(useCtg ? lits.size() : 0);
+    atomic<size_t> first(lits.size());
+    atomic<int> started(0);
+    m_specPool->ParallelFor(lits.size(), [&](int worker, size_t k) {
+        if (!initiation[k] || k > first.load()) return;
+        started++;
+        shared_ptr<SATSolver> slv = SyncSpecSolver(frameLvl, worker);
+        clause cls;
+        cls.reserve(dropCubes[k].size());
+        for (const auto &lit : dropCubes[k]) {
+            cls.push_back(-lit);
+        }
+        slv->AddTempClause(cls);
+        if (m_settings.satSolveInDomain) {
+            cube d = assumptions[k];
+            d.insert(d.end(), dropCubes[k].begin(), dropCubes[k].end());
+            slv->SetTempDomainCOI(d);
+        }
+        bool inductive = !slv->Solve(assumptions[k]);
+        if (inductive) {
+            slv->GetFailed(dropCubes[k], true, cores[k]);
+        } else if (useCtg) {
+            ctgs[k] = slv->GetAssignment(false);
+        }
+        slv->ReleaseTempClause();
+        if (!inductive) return;
+        size_t cur = first.load();
+        while (k < cur && !first.compare_exchange_weak(cur, k)) {}
+    });
+    queries += started.load();
+
+    size_t k = first.load();
+    size_t failed = 0;
+    for (size_t j = 0; j < k && j < lits.size(); ++j) {
+        if (useCtg && initiation[j]) {
+            if (failed == attempts) return false;
+            // A lemma learned since may block the CTG, Down checks the drop again then.
+            bool fresh = m_lemmaLog.size() == logged;
+            if (Down(dropCubes[j], frameLvl, recLvl, triedLits, fresh ? &ctgs[j] : nullptr)) {
+                sort(dropCubes[j].begin(), dropCubes[j].end(), cmp);
+                cb.swap(dropCubes[j]);
+                return true;
+            }
+        }
+        triedLits.insert(lits[j]);
+        failed++;
+    }
+    if (k == lits.size()) return false;
+    if (!InitiationCheck(cores[k])) cores[k] = dropCubes[k];
+    sort(cores[k].begin(), cores[k].end(), cmp);
+    cb.swap(cores[k]);
+    return true;
+}
+
+shared_ptr<SATSolver> BasicIC3::SyncSpecSolver(int lvl, int worker) {
+    auto &spec = m_specSolvers[lvl][worker];
+    if (spec.first == nullptr) {
+        spec.first = make_shared<SATSolver>(m_model, m_settings.solver);
+        if (m_settings.satSolveInDomain) spec.first->SetSolveInDomain();
+        spec.first->AddTrans();
+        spec.first->AddConstraints();
+        spec.first->AddProperty();
+    }
+    // A lemma at F_j is in the solvers of F_1 to F_j, or of F_j only.
+    for (; spec.second < m_lemmaLog.size(); ++spec.second) {
+        const LoggedLemma &entry = m_lemmaLog[spec.second];
+        if (lvl > entry.frameLevel || (!entry.toAll && lvl != entry.frameLevel)) continue;
+        clause lemma;
+        lemma.reserve(entry.blockingCube.size());
+        for (const auto &lit : entry.blockingCube) {
+            lemma.push_back(-lit);
+        }
+        spec.first->AddClause(lemma);
+        if (m_settings.satSolveInDomain) {
+            spec.first->SetDomainCOI(entry.blockingCube);
+        }
+    }
+    return spec.first;
+}
+
+
 void BasicIC3::GeneralizePredecessor(const shared_ptr<State> &predecessorState, const shared_ptr<State> &successorState) {
     m_log.L(3, "Generalizing predecessor. Initial latch size: ", predecessorState->latches.size(), ", input size: ", predecessorState->inputs.size(), ", Successor state latch size: ", successorState->latches.size());
 
+    // Ternary simulation first, the latches of low priority are tried first.
+    if (m_ternaryLifter != nullptr) {
+        cube targets(m_model.GetConstraints());
+        for (const auto &lit : successorState->latches) {
+            targets.push_back(m_model.GetPrimeK(lit, 1));
+        }
+        cube order(predecessorState->latches);
+        OrderAssumption(order);
+        if (m_ternaryLifter->Lift(predecessorState->inputs, order, targets)) {
+            sort(order.begin(), order.end(), cmp);
+            predecessorState->latches.swap(order);
+            m_log.L(3, "Generalized predecessor by simulation. Final latch size: ", predecessorState->latches.size());
+            return;
+        }
+    }
+
     clause succNegationClause;
     succNegationClause.reserve(successorState->latches.size());
     for (const auto &lit : successorState->latches) {
@@ -757,11 +946,11 @@ void BasicIC3::OutputCounterExample() {
             << "b0" << endl;
 
     shared_ptr<State> state = m_cexStart;
-    cexFile << state->GetLatchesString() << endl;
-    cexFile << state->GetInputsString() << endl;
+    cexFile << state->GetLatchesString(m_model.GetNumInputs(), m_model.GetNumLatches()) << endl;
+    cexFile << state->GetInputsString(m_model.GetNumInputs()) << endl;
     while (state->preState != nullptr) {
         state = state->preState;
-        cexFile << state->GetInputsString() << endl;
+        cexFile << state->GetInputsString(m_model.GetNumInputs()) << endl;
     }
 
     cexFile << "." << endl;
@@ -5,6 +5,7 @@
 #include "IncrCheckerHelpers.h"
 #include "Log.h"
 #include "SATSolver.h"
+#include "WorkerPool.h"
 #include <memory>
 #include <random>
 #include <set>
@@ -62,12 +63,17 @@ class BasicIC3 : public BaseAlg {
     void AddNewFrame();
     void AddNewFrames();
     void AddBlockingCube(const cube &blockingCube, int frameLevel, bool toAll);
+    void ImportLemmas();
 
     bool Strengthen();
     bool HandleObligations(set<Obligation> &obligations);
     size_t Generalize(cube &cb, int frameLvl);
     bool MIC(cube &cb, int frameLvl, int recLvl);
-    bool Down(cube &c, int frameLvl, int recLvl, const set<int> &triedLits);
+    bool Down(cube &c, int frameLvl, int recLvl, const set<int> &triedLits,
+              const pair<cube, cube> *ctg = nullptr);
+    bool SpeculateDrops(cube &cb, int i, int frameLvl, int recLvl, set<int> &triedLits,
+                        size_t attempts, int &queries, int &floor);
+    shared_ptr<SATSolver> SyncSpecSolver(int lvl, int worker);
     void GeneralizePredecessor(const shared_ptr<State> &predecessorState, const shared_ptr<State> &successorState);
 
 
@@ -79,16 +85,6 @@ class BasicIC3 : public BaseAlg {
     string FramesInfo() const;
     int PushLemmaForward(const cube &cb, int startLevel);
 
-    struct LitOrder {
-        shared_ptr<Branching> branching;
-
-        LitOrder() {}
-
-        bool operator()(const int &l1, const int &l2) const {
-            return (branching->PriorityOf(l1) > branching->PriorityOf(l2));
-        }
-    } litOrder;
-
     struct BlockerOrder {
         shared_ptr<Branching> branching;
 
@@ -110,7 +106,7 @@ class BasicIC3 : public BaseAlg {
             return;
         }
         if (m_settings.branching == 0) return;
-        sort(c.begin(), c.end(), litOrder);
+        m_branching->Order(c);
     }
 
     void Extend();
@@ -143,6 +139,7 @@ class BasicIC3 : public BaseAlg {
     Model &m_model;
     vector<IC3Frame> m_frames;
     shared_ptr<SATSolver> m_liftSolver;
+    shared_ptr<TernaryLifter> m_ternaryLifter;
     shared_ptr<SATSolver> m_startSolver;
     shared_ptr<SATSolver> m_badPredLiftSolver;
     set<int> m_initialStateSet;
@@ -152,6 +149,19 @@ class BasicIC3 : public BaseAlg {
     int lemmaCount;
     int m_invariantLevel;
     shared_ptr<Branching> m_branching;
+    uint64_t m_busCursor = 0;
+    bool m_importing = false;
+
+    // every blocking cube in the order it was added, replayed into the
+    // per level and worker copies of the frame solvers
+    struct LoggedLemma {
+        cube blockingCube;
+        int frameLevel;
+        bool toAll;
+    };
+    shared_ptr<WorkerPool> m_specPool;
+    vector<vector<pair<shared_ptr<SATSolver>, size_t>>> m_specSolvers;
+    vector<LoggedLemma> m_lemmaLog;
 };
 
 } // namespace car
@@ -9,19 +9,20 @@ FCAR::FCAR(Settings settings,
                        m_model(model),
                        m_log(log),
                        innOrder(model) {
-    State::numInputs = model.GetNumInputs();
-    State::numLatches = model.GetNumLatches();
     m_lastState = nullptr;
-    GLOBAL_LOG = &m_log;
     m_checkResult = CheckResult::Unknown;
+}
 
-    m_settings.satSolveInDomain = m_settings.satSolveInDomain && m_settings.solver == MCSATSolver::minicore;
+FCAR::~FCAR() {
+    StopLiftPipeline();
 }
 
 CheckResult FCAR::Run() {
-    signal(SIGINT, signalHandler);
-
-    if (Check(m_model.GetBad()))
+    bool safe = Check(m_model.GetBad());
+    StopLiftPipeline();
+    if (IsStopped())
+        m_checkResult = CheckResult::Unknown;
+    else if (safe)
         m_checkResult = CheckResult::Safe;
     else
         m_checkResult = CheckResult::Unsafe;
@@ -68,23 +69,28 @@ bool FCAR::Check(int badId) {
     m_k = 0;
     stack<Task> workingStack;
     while (true) {
+        if (IsStopped()) return false;
         [[maybe_unused]] auto frameScope = m_log.Section("FC_Frame");
         m_minUpdateLevel = m_k + 1;
+        vector<shared_ptr<State>> seeds;
         if (m_settings.dt) { // Dynamic Traversal
-            auto dtseq = m_underSequence.GetSeqDT();
-            for (auto state : dtseq) {
-                workingStack.emplace(state, m_k - 1, false);
-            }
+            seeds = m_underSequence.GetSeqDT();
         } else { // from the shallow and the start
             for (int i = m_underSequence.size() - 1; i >= 0; i--) {
                 for (int j = m_underSequence[i].size() - 1; j >= 0; j--) {
-                    workingStack.emplace(m_underSequence[i][j], m_k - 1, false);
+                    seeds.emplace_back(m_underSequence[i][j]);
                 }
             }
         }
+        if (m_oblPool != nullptr && m_k > 0 && seeds.size() >= kParallelObligationThreshold)
+            BlockSeedsParallel(seeds);
+        for (auto state : seeds) {
+            workingStack.emplace(state, m_k - 1, false);
+        }
         m_log.L(2, "Start Frame: ", m_k);
         m_log.L(2, "Working Stack Size: ", workingStack.size());
 
+        ImportLemmas();
         shared_ptr<State> startState = EnumerateStartState();
         // T & c & P & T' & c' & bad' is unsat
         if (m_k > 0 && startState == nullptr && m_overSequence->IsEmpty(m_k)) {
@@ -98,12 +104,17 @@ bool FCAR::Check(int badId) {
             workingStack.emplace(startState, m_k - 1, true);
 
             while (!workingStack.empty()) {
+                if (IsStopped()) return false;
                 [[maybe_unused]] auto taskScope = m_log.Section("FC_Task");
+                if (m_liftThread.joinable()) CollectLifted();
+                if (m_compactor != nullptr && m_compactor->Collect(m_transSolvers) > 0)
+                    m_log.L(2, "Frame Solver Compacted");
                 Task &task = workingStack.top();
 
                 if (m_settings.restart && m_restart->RestartCheck()) {
                     m_log.L(1, "Restarting...");
-                    m_underSequence = UnderSequence();
+                    m_underSequence = UnderSequence(m_settings.underCap, m_settings.asyncLift);
+                    m_overSequence->ClearBlockerMemos();
                     while (workingStack.size() > 1) workingStack.pop();
                     m_restart->UpdateThreshold();
                     m_restart->ResetUcCounts();
@@ -146,9 +157,10 @@ bool FCAR::Check(int badId) {
                     auto p = GetInputAndState(task.frameLevel);
                     m_log.L(3, "Input Detail: ", CubeToStr(p.first));
                     m_log.L(3, "State Detail: ", CubeToStr(p.second));
-                    GeneralizePredecessor(p, task.state);
+                    if (!m_liftThread.joinable()) GeneralizePredecessor(p, task.state);
                     shared_ptr<State> newState =
-                        make_shared<State>(task.state, p.first, p.second, task.state->depth + 1);
+                        m_underSequence.NewState(task.state, p.first, p.second, task.state->depth + 1);
+                    if (m_liftThread.joinable()) PushLiftJob(newState, task.state->latches);
                     m_underSequence.push(newState);
                     if (m_settings.dt) task.state->HasSucc();
                     m_log.L(3, "Get State: ", CubeToStrShort(newState->latches));
@@ -170,15 +182,17 @@ bool FCAR::Check(int badId) {
                     m_log.L(3, "Frames: ", m_overSequence->FramesInfo());
                 }
             } // end while (!workingStack.empty())
+            ImportLemmas();
             startState = EnumerateStartState();
         }
 
         // inv
-        m_invSolver = make_shared<SATSolver>(m_model, MCSATSolver::cadical);
-        IsInvariant(0);
         for (int i = 0; i < m_k; ++i) {
             // propagation
-            if (i >= m_minUpdateLevel) {
+            if (i >= m_minUpdateLevel && m_workerPool != nullptr &&
+                m_overSequence->GetFrame(i)->size() >= kParallelPropagationThreshold) {
+                PropagateParallel(i);
+            } else if (i >= m_minUpdateLevel) {
                 shared_ptr<frame> fi = m_overSequence->GetFrame(i);
                 shared_ptr<frame> fi_plus_1 = m_overSequence->GetFrame(i + 1);
                 frame::iterator iter;
@@ -200,6 +214,7 @@ bool FCAR::Check(int badId) {
 
         m_log.L(1, m_overSequence->FramesInfo());
         m_log.L(3, m_overSequence->FramesDetail());
+        if (m_liftThread.joinable()) m_log.L(2, "Async Lifts: ", m_asyncLifts);
         InitializeStartSolver();
 
         m_k++;
@@ -211,15 +226,26 @@ bool FCAR::Check(int badId) {
 
 void FCAR::Init(int badId) {
     [[maybe_unused]] auto initScope = m_log.Section("FC_Init");
-    cube inputs(State::numInputs, 0);
+    cube inputs(m_model.GetNumInputs(), 0);
     cube latches(m_model.GetInitialState());
     m_initialState.reset(new State(nullptr, inputs, latches, 0));
 
     m_badId = badId;
     m_overSequence = make_shared<OverSequenceSet>(m_model);
-    m_underSequence = UnderSequence();
+    if (m_settings.packedFrames) m_overSequence->SetPacked();
+    m_invChecker = make_shared<InvariantChecker>(m_model, m_overSequence);
+    m_compactor.reset();
+    if (m_settings.ternaryLift) m_ternaryLifter = make_shared<TernaryLifter>(m_model.GetCircuitGraph());
+    if (m_settings.compactSolvers) {
+        m_compactor = make_shared<SolverCompactor>(
+            m_overSequence,
+            [this](int lvl, const vector<cube> &lemmas) { return CloneTransSolver(lvl, lemmas); },
+            [](SATSolver &slv, const cube &uc) { slv.AddUC(uc); });
+    }
+    if (m_lemmaBus != nullptr) m_overSequence->SetLemmaBus(m_lemmaBus, m_lemmaSource);
+    // the lift thread may drop the last reference to a state
+    m_underSequence = UnderSequence(m_settings.underCap, m_settings.asyncLift);
     m_branching = make_shared<Branching>(m_settings.branching);
-    litOrder.branching = m_branching;
     blockerOrder.branching = m_branching;
     m_domainStack.clear();
 
@@ -234,6 +260,7 @@ void FCAR::Init(int badId) {
     if (m_settings.satSolveInDomain) m_liftSolver->SetSolveInDomain();
     m_liftSolver->AddTrans();
     m_liftSolver->SetDomainCOI(m_model.GetConstraints());
+    if (m_settings.asyncLift) StartLiftPipeline();
 
     InitializeStartSolver();
     if (m_settings.searchFromBadPred) {
@@ -250,7 +277,16 @@ void FCAR::Init(int badId) {
         m_badLiftSolver->SetDomainCOI({m_model.GetBad()});
     }
 
-    m_restart.reset(new Restart(m_settings));
+    m_restart.reset(new Restart(m_settings, m_log));
+    if (m_settings.propThreads > 1) m_workerPool = make_shared<WorkerPool>(m_settings.propThreads);
+    if (m_settings.oblThreads > 1) m_oblPool = make_shared<WorkerPool>(m_settings.oblThreads);
+    if (m_settings.specThreads > 1) m_specPool = make_shared<WorkerPool>(m_settings.specThreads);
+    m_workerSolvers.clear();
+    m_levelLemmas.clear();
+    m_levelErased.clear();
+    m_workerSolverWidth = 0;
+    for (auto &pool : {m_workerPool, m_oblPool, m_specPool})
+        if (pool != nullptr) m_workerSolverWidth = max(m_workerSolverWidth, pool->Size());
 }
 
 
@@ -290,6 +326,14 @@ bool FCAR::AddUnsatisfiableCore(const cube &uc, int frameLevel) {
         if (m_settings.solveInProperty) m_transSolvers.back()->AddProperty();
     }
     m_transSolvers[frameLevel]->AddUC(uc);
+    if (m_compactor != nullptr) m_compactor->LemmaAdded(frameLevel, uc);
+    if (m_workerSolverWidth > 0) {
+        if (frameLevel >= m_levelLemmas.size()) m_levelLemmas.resize(frameLevel + 1);
+        m_levelLemmas[frameLevel].emplace_back(uc);
+        // a level the workers have not synced for long keeps no more than its frame
+        if (m_levelLemmas[frameLevel].size() > 2 * m_overSequence->GetFrame(frameLevel)->size() + kLevelLemmasSlack)
+            CompactWorkerLemmas(frameLevel);
+    }
 
     if (frameLevel >= m_k) {
         m_startSolver->AddUC(uc);
@@ -389,6 +433,10 @@ shared_ptr<State> FCAR::EnumerateStartState() {
             // (p) & (!bad | !c) is unsat
             cube partial_latch = p.second;
             m_log.L(3, "Bad State Latches Before Lifting: ", CubeToStr(partial_latch));
+            cube bad_targets(m_model.GetConstraints());
+            bad_targets.emplace_back(m_model.GetBad());
+            if (TernaryLift(p.first, p.second, bad_targets))
+                return shared_ptr<State>(new State(nullptr, p.first, p.second, 0));
 
             // (!bad | !c)
             clause cls;
@@ -432,8 +480,9 @@ shared_ptr<State> FCAR::EnumerateStartState() {
 int FCAR::GetNewLevel(const cube &states, int start) {
     [[maybe_unused]] auto scoped = m_log.Section("FC_GetNewLevel");
 
+    BlockerMemo &memo = m_overSequence->GetBlockerMemo(states);
     for (int i = start; i <= m_k; i++) {
-        if (!m_overSequence->IsBlockedByFrame(states, i)) {
+        if (!m_overSequence->IsBlockedByFrame(states, i, memo)) {
             return i - 1;
         }
     }
@@ -444,60 +493,35 @@ int FCAR::GetNewLevel(const cube &states, int start) {
 
 bool FCAR::IsInvariant(int frameLevel) {
     [[maybe_unused]] auto scoped = m_log.Section("FC_Invariant");
-    shared_ptr<frame> frame_i = m_overSequence->GetFrame(frameLevel);
-
-    if (frameLevel < m_minUpdateLevel) {
-        AddConstraintOr(frame_i);
-        return false;
-    }
-
-    AddConstraintAnd(frame_i);
-    bool result;
-    {
-        [[maybe_unused]] auto satInv = m_log.Section("SAT_Inv");
-        result = !m_invSolver->Solve();
-    }
-    m_invSolver->FlipLastConstrain();
-    AddConstraintOr(frame_i);
+    if (frameLevel < m_minUpdateLevel) return false;
 
-    return result;
+    [[maybe_unused]] auto satInv = m_log.Section("SAT_Inv");
+    return m_invChecker->Check(frameLevel);
 }
 
 
 // ================================================================================
-// @brief: add constraint | O_i
+// @brief: take over the lemmas of the peer engines, each one is revalidated by
+//         O_(i-1) & T & c' being unsat before it enters O_i
 // @input:
 // @output:
 // ================================================================================
-void FCAR::AddConstraintOr(const shared_ptr<frame> f) {
-    cube cls;
-    for (const cube &frame_cube : *f) {
-        int flag = m_invSolver->GetNewVar();
-        cls.push_back(flag);
-        for (int i = 0; i < frame_cube.size(); i++) {
-            m_invSolver->AddClause(cube{-flag, frame_cube[i]});
-        }
+void FCAR::ImportLemmas() {
+    if (m_lemmaBus == nullptr || m_k == 0) return;
+    [[maybe_unused]] auto scoped = m_log.Section("FC_Import");
+    vector<LemmaBus::Entry> entries;
+    m_lemmaBus->Collect(m_busCursor, m_lemmaSource, entries);
+    if (entries.empty()) return;
+
+    int imported = 0;
+    m_overSequence->SetPublish(false);
+    for (auto &e : entries) {
+        int lvl = min(e.level, m_k);
+        if (m_overSequence->IsBlockedByFrame(e.lemma, lvl)) continue;
+        if (Propagate(e.lemma, lvl - 1)) imported++;
     }
-    m_invSolver->AddClause(cls);
-}
-
-
-// ================================================================================
-// @brief: add constraint & !O_i
-// @input:
-// @output:
-// ================================================================================
-void FCAR::AddConstraintAnd(const shared_ptr<frame> f) {
-    int flag = m_invSolver->GetNewVar();
-    for (const cube &frame_cube : *f) {
-        cube cls;
-        for (int i = 0; i < frame_cube.size(); i++) {
-            cls.push_back(-frame_cube[i]);
-        }
-        cls.push_back(-flag);
-        m_invSolver->AddClause(cls);
-    }
-    m_invSolver->AddAssumption(cube{flag});
+    m_overSequence->SetPublish(true);
+    m_log.L(2, "Imported Lemmas: ", imported, " / ", entries.size());
 }
 
 
@@ -508,6 +532,10 @@ void FCAR::AddConstraintAnd(const shared_ptr<frame> f) {
 // ================================================================================
 void FCAR::GeneralizePredecessor(pair<cube, cube> &s, shared_ptr<State> t) {
     [[maybe_unused]] auto scoped = m_log.Section("FC_GenPred");
+    cube targets(m_model.GetConstraints());
+    for (auto l : t->latches) targets.emplace_back(m_model.GetPrime(l));
+    if (TernaryLift(s.first, s.second, targets)) return;
+
     cube partial_latch = s.second;
 
     // (!t' | !c)
@@ -544,6 +572,122 @@ void FCAR::GeneralizePredecessor(pair<cube, cube> &s, shared_ptr<State> t) {
 }
 
 
+// ================================================================================
+// @brief: lift latches by ternary simulation, the latches of low priority are
+//         tried first, so the SAT lifting and this one keep similar literals
+// @input: targets that must stay true for every state of the lifted cube
+// @output: false if the simulation cannot decide the targets, latches unchanged
+// ================================================================================
+bool FCAR::TernaryLift(const cube &inputs, cube &latches, const cube &targets) {
+    if (m_ternaryLifter == nullptr) return false;
+    [[maybe_unused]] auto scoped = m_log.Section("FC_TernaryLift");
+    cube order(latches);
+    OrderAssumption(order);
+    if (!m_ternaryLifter->Lift(inputs, order, targets)) return false;
+    sort(order.begin(), order.end(), cmp);
+    latches.swap(order);
+    return true;
+}
+
+
+// ================================================================================
+// @brief: with --async_lift the main search goes on with the full predecessor
+//         while a thread lifts it, the lifted latches replace the full ones later
+// @input:
+// @output:
+// ================================================================================
+void FCAR::StartLiftPipeline() {
+    m_liftShutdown = false;
+    m_liftThread = thread(&FCAR::LiftLoop, this);
+}
+
+
+void FCAR::StopLiftPipeline() {
+    if (!m_liftThread.joinable()) return;
+    {
+        lock_guard<mutex> lock(m_liftMutex);
+        m_liftShutdown = true;
+        m_liftJobs.clear();
+    }
+    m_liftWakeUp.notify_one();
+    m_liftThread.join();
+    m_liftDone.clear();
+}
+
+
+void FCAR::PushLiftJob(shared_ptr<State> s, const cube &succ) {
+    // the branching is not thread safe, the order is fixed here
+    cube order(s->latches);
+    OrderAssumption(order);
+    {
+        lock_guard<mutex> lock(m_liftMutex);
+        m_liftJobs.push_back({s, s->inputs, s->latches, order, succ});
+    }
+    m_liftWakeUp.notify_one();
+}
+
+
+void FCAR::CollectLifted() {
+    vector<pair<shared_ptr<State>, cube>> done;
+    {
+        lock_guard<mutex> lock(m_liftMutex);
+        if (m_liftDone.empty()) return;
+        done.swap(m_liftDone);
+    }
+    // s & input & T -> t', so the lifted s stays a predecessor of every cube that contains t
+    for (auto &d : done) {
+        d.first->latches.swap(d.second);
+        m_asyncLifts++;
+    }
+}
+
+
+void FCAR::LiftLoop() {
+    while (true) {
+        LiftJob job;
+        {
+            unique_lock<mutex> lock(m_liftMutex);
+            m_liftWakeUp.wait(lock, [this] { return m_liftShutdown || !m_liftJobs.empty(); });
+            if (m_liftShutdown) return;
+            job = move(m_liftJobs.front());
+            m_liftJobs.pop_front();
+        }
+
+        // (!t' | !c)
+        clause cls;
+        cls.reserve(job.succ.size());
+        for (auto l : job.succ) {
+            cls.emplace_back(m_model.GetPrime(-l));
+        }
+        for (auto cons : m_model.GetConstraints()) cls.push_back(-cons);
+        m_liftSolver->AddTempClause(cls);
+        m_liftSolver->SetTempDomainCOI(cls);
+
+        cube partial_latch(job.latches);
+        while (true) {
+            cube assumption(job.order);
+            copy(job.inputs.begin(), job.inputs.end(), back_inserter(assumption));
+            [[maybe_unused]] bool res = m_liftSolver->Solve(assumption);
+            assert(!res);
+            auto dropped = [this](int l) { return !m_liftSolver->IsFailed(l); };
+            cube temp_p(partial_latch);
+            temp_p.erase(remove_if(temp_p.begin(), temp_p.end(), dropped), temp_p.end());
+            if (temp_p.size() >= partial_latch.size())
+                break;
+            else {
+                partial_latch.swap(temp_p);
+                job.order.erase(remove_if(job.order.begin(), job.order.end(), dropped), job.order.end());
+            }
+        }
+        m_liftSolver->ReleaseTempClause();
+        if (partial_latch.size() == job.latches.size()) continue;
+
+        lock_guard<mutex> lock(m_liftMutex);
+        m_liftDone.emplace_back(job.state, move(partial_latch));
+    }
+}
+
+
 // ================================================================================
 // @brief: counter-example to generalization
 // @input:
@@ -564,25 +708,53 @@ bool FCAR::Generalize(cube &uc, int frame_lvl, int rec_lvl) {
 
     if (m_settings.referSkipping)
         for (auto b : uc_blocker) required_lits.emplace(b);
-    vector<cube> failed_ctses;
+    FailedStates failed_ctses;
     OrderAssumption(uc);
     setupScope = m_log.Section("FC_Gen_Loop");
-    for (int i = uc.size() - 1; i >= 0; i--) {
-        if (uc.size() < 2) break;
-        if (required_lits.find(uc.at(i)) != required_lits.end()) continue;
-        [[maybe_unused]] auto iterScope = m_log.Section("FC_Gen_Try");
-        cube temp_uc;
-        temp_uc.reserve(uc.size());
-        for (auto ll : uc)
-            if (ll != uc.at(i)) temp_uc.emplace_back(ll);
-        if (Down(temp_uc, frame_lvl, rec_lvl, failed_ctses)) {
-            uc.swap(temp_uc);
-            OrderAssumption(uc);
-            i = uc.size();
-        } else {
-            required_lits.emplace(uc.at(i));
+    int literals = 0, queries = 0;
+    for (auto l : uc)
+        if (required_lits.find(l) == required_lits.end()) literals++;
+    if (m_settings.genDC) {
+        // a group is tried without ctg, single literals get the usual recursion
+        auto tryDrop = [&](cube &temp_uc, bool single) {
+            [[maybe_unused]] auto iterScope = m_log.Section("FC_Gen_Try");
+            int lvl = single ? rec_lvl : m_settings.ctgMaxRecursionDepth + 1;
+            return Down(temp_uc, frame_lvl, lvl, failed_ctses);
+        };
+        DropLiterals(uc, cube(uc.rbegin(), uc.rend()), required_lits, tryDrop, queries);
+    } else {
+        // the literals from spec_floor on were tried speculatively already
+        bool speculate = m_specPool != nullptr;
+        int spec_floor = uc.size();
+        for (int i = uc.size() - 1; i >= 0; i--) {
+            if (uc.size() < 2) break;
+            if (required_lits.find(uc.at(i)) != required_lits.end()) continue;
+            if (speculate && i < spec_floor) {
+                if (SpeculateDrops(uc, i, frame_lvl, rec_lvl, required_lits, failed_ctses, queries, spec_floor)) {
+                    OrderAssumption(uc);
+                    i = uc.size();
+                    spec_floor = uc.size();
+                    continue;
+                }
+                if (required_lits.find(uc.at(i)) != required_lits.end()) continue;
+            }
+            [[maybe_unused]] auto iterScope = m_log.Section("FC_Gen_Try");
+            cube temp_uc;
+            temp_uc.reserve(uc.size());
+            for (auto ll : uc)
+                if (ll != uc.at(i)) temp_uc.emplace_back(ll);
+            queries++;
+            if (Down(temp_uc, frame_lvl, rec_lvl, failed_ctses)) {
+                uc.swap(temp_uc);
+                OrderAssumption(uc);
+                i = uc.size();
+                spec_floor = uc.size();
+            } else {
+                required_lits.emplace(uc.at(i));
+            }
         }
     }
+    m_log.StatGeneralize(literals, queries);
     setupScope = m_log.Section("FC_Gen_Post");
     sort(uc.begin(), uc.end(), cmp);
     if (uc.size() > uc_blocker.size() && frame_lvl != 0) {
@@ -593,7 +765,7 @@ bool FCAR::Generalize(cube &uc, int frame_lvl, int rec_lvl) {
 }
 
 
-bool FCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses) {
+bool FCAR::Down(cube &uc, int frame_lvl, int rec_lvl, FailedStates &failed_ctses, const pair<cube, cube> *pred) {
     [[maybe_unused]] auto downSetup = m_log.Section("FC_Dn_Set");
     int ctgs = 0;
     m_log.L(3, "Down:", CubeToStr(uc));
@@ -602,9 +774,9 @@ bool FCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses
     shared_ptr<State> p_ucs(new State(nullptr, cube(), uc, 0));
     downSetup = m_log.Section("FC_Dn_Loop");
     while (true) {
-        m_transSolvers[frame_lvl]->SetTempDomainCOI(assumption);
-        // F_i & T & temp_uc'
-        if (!IsReachable(frame_lvl, assumption, "SAT_R_Down")) {
+        // F_i & T & temp_uc', known SAT when a speculative drop hands in its predecessor
+        if (pred == nullptr) m_transSolvers[frame_lvl]->SetTempDomainCOI(assumption);
+        if (pred == nullptr && !IsReachable(frame_lvl, assumption, "SAT_R_Down")) {
             sort(uc.begin(), uc.end(), cmp);
             auto uc_ctg = GetUnsatCore(frame_lvl, uc);
             if (uc.size() < uc_ctg.size()) return false; // there are cases that uc_ctg longer than uc
@@ -614,8 +786,10 @@ bool FCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses
             return false;
         } else {
             [[maybe_unused]] auto ctgScope = m_log.Section("FC_Dn_CTG");
-            auto p = GetInputAndState(frame_lvl);
-            GeneralizePredecessor(p, p_ucs);
+            auto p = pred != nullptr ? *pred : GetInputAndState(frame_lvl);
+            pred = nullptr;
+            // the lift thread owns m_liftSolver, the ctg stays a full state then
+            if (!m_liftThread.joinable()) GeneralizePredecessor(p, p_ucs);
             shared_ptr<State> cts(new State(nullptr, p.first, p.second, 0));
             if (DownHasFailed(cts->latches, failed_ctses)) return false;
 
@@ -649,9 +823,119 @@ bool FCAR::Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses
 }
 
 
-bool FCAR::DownHasFailed(const cube &s, const vector<cube> &failed_ctses) {
-    for (auto f : failed_ctses) {
+// ================================================================================
+// @brief: drops of the next literals uc[i], uc[i-1], ... are checked at once on
+//         copies of the level solver, the first one in the order of the loop that
+//         is unsat commits and the later ones are not started any more.
+//         with ctg, the failed drops before it go through Down in order on the
+//         predecessors the workers found, so their first query is not solved again
+// @input: floor is set to the last index of the batch
+// @output: true if uc is shrunk
+// ================================================================================
+bool FCAR::SpeculateDrops(cube &uc, int i, int frame_lvl, int rec_lvl, unordered_set<int> &required_lits,
+                          FailedStates &failed_ctses, int &queries, int &floor) {
+    [[maybe_unused]] auto scoped = m_log.Section("FC_Gen_Spec");
+    cube lits;
+    int last = i;
+    for (int j = i; j >= 0 && lits.size() < m_specPool->Size(); j--) {
+        if (required_lits.find(uc[j]) != required_lits.end()) continue;
+        lits.emplace_back(uc[j]);
+        last = j;
+    }
+    if (lits.size() < 2) return false;
+    floor = last;
+
+    vector<cube> cands(lits.size());
+    for (size_t k = 0; k < lits.size(); ++k) {
+        cands[k].reserve(uc.size() - 1);
+        for (auto ll : uc)
+            if (ll != lits[k]) cands[k].emplace_back(ll);
+    }
+    ReserveWorkerSolvers(frame_lvl);
+    bool ctg = rec_lvl <= m_settings.ctgMaxRecursionDepth;
+    uint64_t version = m_overSequence->GetFrameVersion(frame_lvl);
+
+    // the workers only touch their own solver and slot
+    vector<cube> cores(cands.size());
+    vector<pair<cube, cube>> preds(ctg ? cands.size() : 0);
+    atomic<size_t> first(cands.size());
+    atomic<int> started(0);
+    m_specPool->ParallelFor(cands.size(), [&](int worker, size_t k) {
+        if (k > first.load()) return;
+        started++;
+        shared_ptr<SATSolver> slv = SyncWorkerSolver(frame_lvl, worker);
+        cube assumption(cands[k]);
+        GetPrimed(assumption);
+        slv->SetTempDomainCOI(assumption);
+        if (slv->Solve(assumption)) {
+            if (ctg) preds[k] = slv->GetAssignment(false);
+            return;
+        }
+        sort(cands[k].begin(), cands[k].end(), cmp);
+        slv->GetFailed(cands[k], true, cores[k]);
+        size_t cur = first.load();
+        while (k < cur && !first.compare_exchange_weak(cur, k)) {}
+    });
+    queries += started.load();
+
+    size_t k = first.load();
+    for (size_t j = 0; j < k && j < lits.size(); ++j) {
+        if (ctg) {
+            // a ctg lemma on this level may block the predecessor, Down solves again then
+            bool fresh = m_overSequence->GetFrameVersion(frame_lvl) == version;
+            if (Down(cands[j], frame_lvl, rec_lvl, failed_ctses, fresh ? &preds[j] : nullptr)) {
+                uc.swap(cands[j]);
+                return true;
+            }
+        }
+        required_lits.emplace(lits[j]);
+    }
+    if (k == cands.size()) return false;
+    uc.swap(cores[k]);
+    return true;
+}
+
+
+// the main thread makes the slots of the level before the workers sync them,
+// the lemmas the frame has erased since are not replayed
+void FCAR::ReserveWorkerSolvers(int lvl) {
+    size_t size = lvl + 1;
+    if (m_workerSolvers.size() < size)
+        m_workerSolvers.resize(size, vector<pair<shared_ptr<SATSolver>, size_t>>(m_workerSolverWidth));
+    if (m_levelLemmas.size() < size) m_levelLemmas.resize(size);
+    if (m_levelErased.size() < size) m_levelErased.resize(size, 0);
+    if (m_overSequence->GetErasedCount(lvl) != m_levelErased[lvl]) CompactWorkerLemmas(lvl);
+}
+
+
+void FCAR::CompactWorkerLemmas(int lvl) {
+    size_t size = lvl + 1;
+    if (m_workerSolvers.size() < size)
+        m_workerSolvers.resize(size, vector<pair<shared_ptr<SATSolver>, size_t>>(m_workerSolverWidth));
+    if (m_levelErased.size() < size) m_levelErased.resize(size, 0);
+    m_levelErased[lvl] = m_overSequence->GetErasedCount(lvl);
+    CompactLevelLemmas(m_levelLemmas[lvl], m_workerSolvers[lvl], *m_overSequence->GetFrame(lvl));
+}
+
+
+shared_ptr<SATSolver> FCAR::SyncWorkerSolver(int lvl, int worker) {
+    auto &slot = m_workerSolvers[lvl][worker];
+    const vector<cube> &lemmas = m_levelLemmas[lvl];
+    if (slot.first == nullptr) {
+        slot.first = CloneTransSolver(lvl, *m_overSequence->GetFrame(lvl));
+        slot.second = lemmas.size();
+    }
+    for (; slot.second < lemmas.size(); ++slot.second) slot.first->AddUC(lemmas[slot.second]);
+    return slot.first;
+}
+
+
+bool FCAR::DownHasFailed(const cube &s, const FailedStates &failed_ctses) {
+    uint64_t sig = CubeSignature(s);
+    for (size_t i = 0; i < failed_ctses.cubes.size(); ++i) {
         // if f->s , return true
+        if ((failed_ctses.sigs[i] & ~sig) != 0) continue;
+        const cube &f = failed_ctses.cubes[i];
         if (f.size() > s.size()) continue;
         if (includes(s.begin(), s.end(), f.begin(), f.end(), cmp)) return true;
     }
@@ -723,6 +1007,113 @@ bool FCAR::Propagate(const cube &c, int lvl) {
 }
 
 
+// ================================================================================
+// @brief: propagate the cubes of O_i on per-worker copies of the level solver,
+//         the cores are added to O_i+1 in the iteration order of O_i
+// @input:
+// @output:
+// ================================================================================
+void FCAR::PropagateParallel(int lvl) {
+    [[maybe_unused]] auto scoped = m_log.Section("FC_PropPar");
+    const frame &fi = *m_overSequence->GetFrame(lvl);
+    shared_ptr<frame> fi_plus_1 = m_overSequence->GetFrame(lvl + 1);
+    vector<const cube *> todo;
+    for (const cube &uc : fi) {
+        if (fi_plus_1->find(uc) != fi_plus_1->end()) continue; // propagated
+        todo.emplace_back(&uc);
+    }
+
+    // the workers only touch their own solver and slot
+    ReserveWorkerSolvers(lvl);
+    vector<cube> cores(todo.size());
+    vector<uint8_t> blocked(todo.size(), 0);
+    m_workerPool->ParallelFor(todo.size(), [&](int worker, size_t i) {
+        shared_ptr<SATSolver> slv = SyncWorkerSolver(lvl, worker);
+        cube assumption(*todo[i]);
+        GetPrimed(assumption);
+        slv->SetTempDomainCOI(assumption);
+        if (slv->Solve(assumption)) return;
+        slv->GetFailed(*todo[i], true, cores[i]);
+        blocked[i] = 1;
+    });
+
+    for (size_t i = 0; i < todo.size(); ++i) {
+        if (!blocked[i]) continue;
+        AddUnsatisfiableCore(cores[i], lvl + 1);
+        m_branching->Update(*todo[i]);
+    }
+}
+
+
+// ================================================================================
+// @brief: the states of the under sequence that start a frame all query O_(k-1),
+//         so they are checked at once on copies of that solver, the blocked ones
+//         get their cores generalized on O_(k-1) in seed order and put in O_k,
+//         the search skips them. the rest of the obligations stay sequential,
+//         there is no work-stealing scheduler over the levels
+// @input:
+// @output:
+// ================================================================================
+void FCAR::BlockSeedsParallel(const vector<shared_ptr<State>> &seeds) {
+    [[maybe_unused]] auto scoped = m_log.Section("FC_BlockPar");
+    int lvl = m_k - 1;
+    vector<State *> todo;
+    for (auto &s : seeds) {
+        if (m_overSequence->IsBlockedByFrame(s->latches, m_k)) continue;
+        todo.emplace_back(s.get());
+    }
+    if (todo.size() < kParallelObligationThreshold) return;
+
+    // the workers only touch their own solver and slot
+    ReserveWorkerSolvers(lvl);
+    vector<cube> cores(todo.size());
+    vector<uint8_t> blocked(todo.size(), 0);
+    m_oblPool->ParallelFor(todo.size(), [&](int worker, size_t i) {
+        shared_ptr<SATSolver> slv = SyncWorkerSolver(lvl, worker);
+        cube assumption(todo[i]->latches);
+        GetPrimed(assumption);
+        slv->SetTempDomainCOI(assumption);
+        if (slv->Solve(assumption)) return;
+        slv->GetFailed(todo[i]->latches, true, cores[i]);
+        blocked[i] = 1;
+    });
+
+    int numBlocked = 0;
+    for (size_t i = 0; i < todo.size(); ++i) {
+        if (!blocked[i]) continue;
+        if (m_settings.dt) todo[i]->HasUC();
+        numBlocked++;
+        // a lemma of an earlier seed may block this one already
+        if (m_overSequence->IsBlockedByFrame(todo[i]->latches, m_k)) continue;
+        cube &uc = cores[i];
+        // O_(k-1) & T alone is UNSAT, generalization starts from the whole state
+        if (uc.empty()) uc = todo[i]->latches;
+        if (Generalize(uc, lvl))
+            m_branching->Update(uc);
+        AddUnsatisfiableCore(uc, m_k);
+    }
+    m_log.L(2, "Blocked Seeds: ", numBlocked, " / ", todo.size());
+}
+
+
+// ================================================================================
+// @brief: a fresh solver equal to m_transSolvers[lvl], O_i & T & c
+// @input:
+// @output:
+// ================================================================================
+template <typename Lemmas>
+shared_ptr<SATSolver> FCAR::CloneTransSolver(int lvl, const Lemmas &lemmas) {
+    auto slv = make_shared<SATSolver>(m_model, m_settings.solver);
+    if (m_settings.satSolveInDomain) slv->SetSolveInDomain();
+    slv->AddTrans();
+    slv->AddConstraints();
+    if (lvl == 0) slv->AddInitialClauses();
+    if (m_settings.solveInProperty) slv->AddProperty();
+    for (const cube &uc : lemmas) slv->AddUC(uc);
+    return slv;
+}
+
+
 int FCAR::PropagateUp(const cube &c, int lvl) {
     [[maybe_unused]] auto scoped = m_log.Section("FC_PropUp");
     while (lvl < m_k) {
@@ -749,25 +1140,16 @@ pair<cube, cube> FCAR::GetInputAndState(int lvl) {
 
 cube FCAR::GetUnsatCore(int lvl, const cube &state) {
     [[maybe_unused]] auto scoped = m_log.Section("DS_UCore");
-    const unordered_set<int> &conflict = m_transSolvers[lvl]->GetConflict();
     cube res;
-    for (auto l : state) {
-        int p = m_model.GetPrime(l);
-        if (conflict.find(p) != conflict.end())
-            res.emplace_back(l);
-    }
+    m_transSolvers[lvl]->GetFailed(state, true, res);
     return res;
 }
 
 
 cube FCAR::GetUnsatAssumption(shared_ptr<SATSolver> solver, const cube &assumptions) {
     [[maybe_unused]] auto scoped = m_log.Section("DS_UAssump");
-    const unordered_set<int> &conflict = solver->GetConflict();
     cube res;
-    for (auto a : assumptions) {
-        if (conflict.find(a) != conflict.end())
-            res.emplace_back(a);
-    }
+    solver->GetFailed(assumptions, false, res);
     return res;
 }
 
@@ -945,11 +1327,11 @@ void FCAR::OutputCounterExample(int bad) {
             << "b0" << endl;
 
     shared_ptr<State> state = m_lastState;
-    cexFile << state->GetLatchesString() << endl;
-    cexFile << state->GetInputsString() << endl;
+    cexFile << state->GetLatchesString(m_model.GetNumInputs(), m_model.GetNumLatches()) << endl;
+    cexFile << state->GetInputsString(m_model.GetNumInputs()) << endl;
     while (state->preState != nullptr) {
         state = state->preState;
-        cexFile << state->GetInputsString() << endl;
+        cexFile << state->GetInputsString(m_model.GetNumInputs()) << endl;
     }
 
     cexFile << "." << endl;
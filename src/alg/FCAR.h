@@ -5,8 +5,13 @@
 #include "IncrCheckerHelpers.h"
 #include "Log.h"
 #include "SATSolver.h"
+#include "WorkerPool.h"
 #include "random"
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -17,6 +22,7 @@ class FCAR : public BaseAlg {
     FCAR(Settings settings,
          Model &model,
          Log &log);
+    ~FCAR();
     CheckResult Run() override;
     void Witness() override;
 
@@ -33,15 +39,7 @@ class FCAR : public BaseAlg {
 
     bool IsInvariant(int frameLevel);
 
-    struct LitOrder {
-        shared_ptr<Branching> branching;
-
-        LitOrder() {}
-
-        bool operator()(const int &l1, const int &l2) const {
-            return (branching->PriorityOf(l1) > branching->PriorityOf(l2));
-        }
-    } litOrder;
+    void ImportLemmas();
 
     struct InnOrder {
         Model &m;
@@ -79,7 +77,7 @@ class FCAR : public BaseAlg {
             return;
         }
         if (m_settings.branching == 0) return;
-        stable_sort(c.begin(), c.end(), litOrder);
+        m_branching->Order(c);
         if (m_settings.internalSignals) {
             stable_sort(c.begin(), c.end(), innOrder);
         }
@@ -95,14 +93,43 @@ class FCAR : public BaseAlg {
 
     void GeneralizePredecessor(pair<cube, cube> &s, shared_ptr<State> t);
 
+    bool TernaryLift(const cube &inputs, cube &latches, const cube &targets);
+
+    void StartLiftPipeline();
+
+    void StopLiftPipeline();
+
+    void PushLiftJob(shared_ptr<State> s, const cube &succ);
+
+    void CollectLifted();
+
+    void LiftLoop();
+
     bool Generalize(cube &uc, int frame_lvl, int rec_lvl = 1);
 
-    bool Down(cube &uc, int frame_lvl, int rec_lvl, vector<cube> &failed_ctses);
+    bool Down(cube &uc, int frame_lvl, int rec_lvl, FailedStates &failed_ctses,
+              const pair<cube, cube> *pred = nullptr);
 
-    bool DownHasFailed(const cube &s, const vector<cube> &failed_ctses);
+    bool DownHasFailed(const cube &s, const FailedStates &failed_ctses);
+
+    bool SpeculateDrops(cube &uc, int i, int frame_lvl, int rec_lvl, unordered_set<int> &required_lits,
+                        FailedStates &failed_ctses, int &queries, int &floor);
+
+    void ReserveWorkerSolvers(int lvl);
+
+    void CompactWorkerLemmas(int lvl);
+
+    shared_ptr<SATSolver> SyncWorkerSolver(int lvl, int worker);
 
     bool Propagate(const cube &c, int lvl);
 
+    void PropagateParallel(int lvl);
+
+    void BlockSeedsParallel(const vector<shared_ptr<State>> &seeds);
+
+    template <typename Lemmas>
+    shared_ptr<SATSolver> CloneTransSolver(int lvl, const Lemmas &lemmas);
+
     int PropagateUp(const cube &c, int lvl);
 
     bool IsReachable(int lvl, const cube &assumption, const string &label);
@@ -117,10 +144,6 @@ class FCAR : public BaseAlg {
 
     bool CheckInit(shared_ptr<State> s);
 
-    void AddConstraintOr(const shared_ptr<frame> f);
-
-    void AddConstraintAnd(const shared_ptr<frame> f);
-
     pair<cube, cube> GetInputAndState(int lvl);
 
     cube GetUnsatCore(int lvl, const cube &state);
@@ -138,14 +161,47 @@ class FCAR : public BaseAlg {
     Model &m_model;
     shared_ptr<State> m_initialState;
     vector<shared_ptr<SATSolver>> m_transSolvers;
+    shared_ptr<SolverCompactor> m_compactor;
     shared_ptr<SATSolver> m_liftSolver;
+    shared_ptr<TernaryLifter> m_ternaryLifter;
     shared_ptr<SATSolver> m_badLiftSolver;
-    shared_ptr<SATSolver> m_invSolver;
+    shared_ptr<InvariantChecker> m_invChecker;
     shared_ptr<SATSolver> m_startSolver;
     shared_ptr<Branching> m_branching;
     shared_ptr<State> m_lastState;
     shared_ptr<Restart> m_restart;
+    shared_ptr<WorkerPool> m_workerPool;
+    static constexpr int kParallelPropagationThreshold = 256;
+    shared_ptr<WorkerPool> m_oblPool;
+    static constexpr int kParallelObligationThreshold = 16;
+    shared_ptr<WorkerPool> m_specPool;
+    // per level and worker a copy of m_transSolvers[lvl] and the number of
+    // lemmas of m_levelLemmas[lvl] it holds, shared by the pools as they
+    // never run at the same time
+    vector<vector<pair<shared_ptr<SATSolver>, size_t>>> m_workerSolvers;
+    int m_workerSolverWidth = 0;
+    vector<vector<cube>> m_levelLemmas;
+    vector<uint64_t> m_levelErased; // erased count of the frame at the last compaction
+    static constexpr size_t kLevelLemmasSlack = 64;
     vector<cube> m_domainStack;
+
+    // the lift thread owns m_liftSolver and never touches a State,
+    // the main thread swaps the lifted latches in between two tasks
+    struct LiftJob {
+        shared_ptr<State> state;
+        cube inputs;
+        cube latches;
+        cube order; // latches in the order of the assumption
+        cube succ;
+    };
+    thread m_liftThread;
+    mutex m_liftMutex;
+    condition_variable m_liftWakeUp;
+    deque<LiftJob> m_liftJobs;
+    vector<pair<shared_ptr<State>, cube>> m_liftDone;
+    bool m_liftShutdown = false;
+    int m_asyncLifts = 0;
+    uint64_t m_busCursor = 0;
 };
 
 
@@ -0,0 +1,111 @@
+#include "Portfolio.h"
+#include "BCAR.h"
+#include "BMC.h"
+#include "BasicIC3.h"
+#include "FCAR.h"
+#include <pthread.h>
+#include <thread>
+
+namespace car {
+
+Portfolio::Portfolio(Settings settings,
+                     Model &model,
+                     Log &log) : m_settings(settings),
+                                 m_model(model),
+                                 m_log(log),
+                                 m_stop(false),
+                                 m_winner(-1) {
+    m_checkResult = CheckResult::Unknown;
+    if (m_settings.shareLemmas) m_lemmaBus = make_shared<LemmaBus>();
+
+    // kissat has no assumptions, only BMC can use it
+    MCSATSolver carSolver = m_settings.solver == MCSATSolver::kissat ? MCSATSolver::minisat : m_settings.solver;
+    AddEngine("fcar", MCAlgorithm::FCAR, carSolver);
+    if (carSolver != MCSATSolver::minicore) {
+        AddEngine("fcar-minicore", MCAlgorithm::FCAR, MCSATSolver::minicore);
+        m_engines.back().settings.satSolveInDomain = !m_settings.internalSignals;
+    }
+    // the witness writer of BCAR asserts, it only races when no witness is requested
+    if (m_settings.witnessOutputDir.empty()) AddEngine("bcar", MCAlgorithm::BCAR, carSolver);
+    AddEngine("ic3", MCAlgorithm::IC3, carSolver);
+    AddEngine("bmc", MCAlgorithm::BMC, m_settings.solver);
+}
+
+
+void Portfolio::AddEngine(const string &name, MCAlgorithm alg, MCSATSolver solver) {
+    Engine engine;
+    engine.name = name;
+    engine.settings = m_settings;
+    engine.settings.alg = alg;
+    engine.settings.solver = solver;
+    m_engines.emplace_back(std::move(engine));
+}
+
+
+CheckResult Portfolio::Run() {
+    m_log.L(1, "Portfolio: ", m_engines.size(), " engines");
+
+    // SIGINT is handled by the main thread only, the workers may hold the output lock
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+    m_model.SetSharedUnrolling();
+    vector<thread> workers;
+    workers.reserve(m_engines.size());
+    for (int i = 0; i < m_engines.size(); ++i) {
+        workers.emplace_back(&Portfolio::RunEngine, this, std::ref(m_engines[i]), i);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    for (auto &w : workers) w.join();
+
+    int winner = m_winner.load();
+    if (winner >= 0) {
+        m_checkResult = m_engines[winner].result;
+        m_log.L(1, "Portfolio: decided by ", m_engines[winner].name);
+    }
+    return m_checkResult;
+}
+
+
+void Portfolio::RunEngine(Engine &engine, int index) {
+    engine.log = make_unique<Log>(m_settings.verbosity);
+    switch (engine.settings.alg) {
+    case MCAlgorithm::FCAR:
+        engine.checker = make_unique<FCAR>(engine.settings, m_model, *engine.log);
+        break;
+    case MCAlgorithm::BCAR:
+        engine.checker = make_unique<BCAR>(engine.settings, m_model, *engine.log);
+        break;
+    case MCAlgorithm::BMC:
+        engine.checker = make_unique<BMC>(engine.settings, m_model, *engine.log);
+        break;
+    case MCAlgorithm::IC3:
+        engine.checker = make_unique<BasicIC3>(engine.settings, m_model, *engine.log);
+        break;
+    default:
+        return;
+    }
+    engine.checker->SetStopFlag(&m_stop);
+    if (m_lemmaBus != nullptr) engine.checker->SetLemmaBus(m_lemmaBus, index);
+
+    engine.result = engine.checker->Run();
+    m_log.L(1, "Portfolio: ", engine.name, " finished");
+    if (engine.result == CheckResult::Unknown) return;
+
+    int expected = -1;
+    if (m_winner.compare_exchange_strong(expected, index)) {
+        m_stop.store(true);
+    }
+}
+
+
+void Portfolio::Witness() {
+    int winner = m_winner.load();
+    if (winner < 0) return;
+    m_engines[winner].checker->Witness();
+}
+
+} // namespace car
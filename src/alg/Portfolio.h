@@ -0,0 +1,50 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "BaseAlg.h"
+#include "IncrCheckerHelpers.h"
+#include "Log.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace car {
+
+// races several engines on their own threads over the shared model,
+// the first definitive result stops the others
+class Portfolio : public BaseAlg {
+  public:
+    Portfolio(Settings settings,
+              Model &model,
+              Log &log);
+
+    CheckResult Run() override;
+    void Witness() override;
+
+  private:
+    struct Engine {
+        string name;
+        Settings settings;
+        unique_ptr<Log> log;
+        unique_ptr<BaseAlg> checker;
+        CheckResult result = CheckResult::Unknown;
+    };
+
+    void AddEngine(const string &name, MCAlgorithm alg, MCSATSolver solver);
+
+    void RunEngine(Engine &engine, int index);
+
+    Settings m_settings;
+    Model &m_model;
+    Log &m_log;
+    vector<Engine> m_engines;
+    atomic<bool> m_stop;
+    atomic<int> m_winner;
+    shared_ptr<LemmaBus> m_lemmaBus;
+    CheckResult m_checkResult;
+};
+
+} // namespace car
+
+#endif
@@ -178,6 +178,37 @@ void CircuitGraph::COIRefine() {
 }
 
 
+vector<int> CircuitGraph::COILatches(int id) {
+    unordered_set<int> coi_ids;
+    vector<int> todo_stack;
+    vector<int> coi_latches;
+
+    coi_ids.emplace(abs(id));
+    todo_stack.emplace_back(abs(id));
+    while (!todo_stack.empty()) {
+        int cur = todo_stack.back();
+        todo_stack.pop_back();
+
+        vector<int> next;
+        auto gate = gatesMap.find(cur);
+        if (gate != gatesMap.end()) {
+            next = gate->second.fanins;
+        } else if (latchesSet.find(cur) != latchesSet.end()) {
+            coi_latches.emplace_back(cur);
+            next.emplace_back(latchNextMap[cur]);
+        }
+        for (int n : next) {
+            if (coi_ids.find(abs(n)) == coi_ids.end()) {
+                coi_ids.emplace(abs(n));
+                todo_stack.emplace_back(abs(n));
+            }
+        }
+    }
+    sort(coi_latches.begin(), coi_latches.end());
+    return coi_latches;
+}
+
+
 bool CircuitGraph::TryMakeXORGate(const shared_ptr<aiger> aig, const unsigned a, unordered_set<unsigned> &coi_lits) {
     aiger_and *aa = aiger_is_and(aig.get(), a);
     assert(aa != nullptr);
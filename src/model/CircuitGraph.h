@@ -92,6 +92,9 @@ class CircuitGraph {
     // refine the COI of property & constraints, get new model inputs, latches, and gates
     void COIRefine();
 
+    // latches in the sequential COI of id, sorted
+    vector<int> COILatches(int id);
+
     // variables really matter
     vector<int> modelInputs;
     vector<int> modelLatches;
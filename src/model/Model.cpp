@@ -1,5 +1,6 @@
 #include "Model.h"
 #include "DAGCNFSimplifier.h"
+#include "WorkerPool.h"
 #include <bitset>
 
 
@@ -74,19 +75,21 @@ Model::Model(Settings settings, Log &log) : m_settings(settings),
     // create circuit graph
     m_circuitGraph = make_shared<CircuitGraph>(m_aiger);
 
-    // multiple bad to check
+    // bad to check
     int num_bad = m_circuitGraph->bad.size();
-    if (num_bad > 1) {
-        m_log.L(0, "aiger has more than one safety property to check.");
-        exit(0);
-    } else if (num_bad == 0) {
+    if (num_bad == 0) {
         m_log.L(0, "aiger has no safety property to check.");
         exit(0);
     }
+    if (num_bad > 1 && !settings.witnessOutputDir.empty()) {
+        m_log.L(0, "witnesses (-w) are not supported for multiple properties.");
+        exit(1);
+    }
 
     m_log.L(1, "Model initialized: ",
             m_circuitGraph->numInputs, " inputs, ", m_circuitGraph->numLatches, " latches, ",
-            m_circuitGraph->numAnds, " gates, ", m_circuitGraph->numConstraints, " constraints.");
+            m_circuitGraph->numAnds, " gates, ", m_circuitGraph->numConstraints, " constraints, ",
+            num_bad, " properties.");
     m_log.L(1, "COI Refined Model: ",
             m_circuitGraph->modelInputs.size(), " inputs, ", m_circuitGraph->modelLatches.size(), " latches, ", m_circuitGraph->modelGates.size(), " gates.");
     m_maxId = m_circuitGraph->numVar + 1;
@@ -113,7 +116,7 @@ Model::Model(Settings settings, Log &log) : m_settings(settings),
     // initial state
     CollectInitialState();
 
-    // bad property
+    // bad property, the others are selected by SetProperty
     m_bad = m_circuitGraph->bad[0];
 
     // prime variable mapping
@@ -197,6 +200,41 @@ void Model::ApplyEquivalence() {
 }
 
 
+void Model::SetProperty(int index) {
+    m_bad = m_circuitGraph->bad[index];
+}
+
+
+vector<vector<int>> Model::GetPropertyGroups() {
+    // properties sharing a latch in their cones fall into the same group
+    int num_bad = m_circuitGraph->bad.size();
+    vector<int> group(num_bad);
+    for (int i = 0; i < num_bad; i++) group[i] = i;
+    auto find = [&](int i) {
+        while (group[i] != i) i = group[i] = group[group[i]];
+        return i;
+    };
+
+    unordered_map<int, int> latchOwner;
+    for (int i = 0; i < num_bad; i++) {
+        for (int l : m_circuitGraph->COILatches(m_circuitGraph->bad[i])) {
+            auto it = latchOwner.emplace(l, i).first;
+            int a = find(it->second), b = find(i);
+            if (a != b) group[max(a, b)] = min(a, b);
+        }
+    }
+
+    vector<vector<int>> groups;
+    unordered_map<int, int> groupIndex;
+    for (int i = 0; i < num_bad; i++) {
+        auto it = groupIndex.emplace(find(i), groups.size()).first;
+        if (it->second == groups.size()) groups.emplace_back();
+        groups[it->second].emplace_back(i);
+    }
+    return groups;
+}
+
+
 void Model::UpdateDependencyMap() {
     m_dependencyVec.assign(m_maxId + 1, vector<int>());
     for (int i = m_circuitGraph->modelGates.size() - 1; i >= 0; i--) {
@@ -223,7 +261,11 @@ void Model::UpdateDependencyMap() {
 
 void Model::UpdateDependencyVecDAGCNF() {
     m_dependencyVec.assign(m_maxId + 1, vector<int>());
-    for (auto &c : m_clauses) {
+    m_definingClauses.assign(m_maxId + 1, vector<int>());
+    for (size_t j = 0; j < m_clauses.size(); ++j) {
+        auto &c = m_clauses[j];
+        if (c.empty()) continue;
+        m_definingClauses[abs(c.back())].emplace_back(j);
         for (size_t i = 0; i + 1 < c.size(); ++i) {
             m_dependencyVec[abs(c.back())].emplace_back(abs(c[i]));
         }
@@ -266,14 +308,12 @@ void Model::CollectInitialState() {
 void Model::CollectNextValueMapping() {
     // reset
     m_maxId = m_circuitGraph->numVar + 1;
+    m_primeMap.clear();
     m_primeMaps.clear();
-    m_primeMaps.push_back(unordered_map<int, int>());
-
-    unordered_map<int, int> &prime_map = m_primeMaps[0];
 
     for (auto l : m_circuitGraph->latches) {
         int next = m_circuitGraph->latchNextMap[l];
-        prime_map[l] = next;
+        m_primeMap[l] = next;
     }
 }
 
@@ -358,9 +398,13 @@ void Model::EnsureCOICache(int v) {
 
 int Model::GetPrimeK(const int id, int k) {
     if (k == 0) return id;
-    if (k >= m_primeMaps.size())
-        m_primeMaps.push_back(unordered_map<int, int>());
     if (IsLatch(id)) return GetPrimeK(GetPrime(id), k - 1);
+    if (k == 1 && IsInnard(id)) return GetPrime(id);
+
+    unique_lock<mutex> lock(m_primeMutex, defer_lock);
+    if (m_sharedUnrolling) lock.lock();
+    while (k > m_primeMaps.size())
+        m_primeMaps.push_back(unordered_map<int, int>());
 
     unordered_map<int, int> &k_map = m_primeMaps[k - 1];
     unordered_map<int, int>::iterator it = k_map.find(abs(id));
@@ -373,6 +417,13 @@ int Model::GetPrimeK(const int id, int k) {
 }
 
 
+int Model::GetNewAuxiliaryId() {
+    unique_lock<mutex> lock(m_primeMutex, defer_lock);
+    if (m_sharedUnrolling) lock.lock();
+    return GetNewId();
+}
+
+
 int Model::InnardsLogiclvlDFS(int id) {
     auto it = m_innards_lvl.find(id);
     if (it != m_innards_lvl.end())
@@ -414,7 +465,7 @@ void Model::CollectInnards() {
             // build a new gate
             CircuitGate gate(m_circuitGraph->gatesMap[g]);
             if (GetPrime(g) == 0) {
-                m_primeMaps[0].insert(pair<int, int>(g, GetNewId()));
+                m_primeMap.insert(pair<int, int>(g, GetNewId()));
             }
             int p_fanout = GetPrime(g);
             gate.fanout = p_fanout;
@@ -465,7 +516,7 @@ void Model::SimplifyClauses() {
         }
     }
     solver->freeze(TrueId());
-    solver->freeze(m_bad);
+    for (int b : m_circuitGraph->bad) solver->freeze(b);
 
     class carClauseIterator : public CaDiCaL::ClauseIterator {
       public:
@@ -505,7 +556,7 @@ void Model::SimplifyDAGClauses() {
         }
     }
     simplifier.FreezeVar(TrueId());
-    simplifier.FreezeVar(m_bad);
+    for (int b : m_circuitGraph->bad) simplifier.FreezeVar(b);
 
     m_clauses = simplifier.Simplify(m_clauses, TrueId());
 }
@@ -582,6 +633,18 @@ bool Model::SimplifyModelByTernarySimulation() {
 }
 
 
+// classes of at least two candidates, sorted the way the checks expect
+static vector<vector<int>> CandidateClasses(const VarMapN64 &signatures) {
+    vector<vector<int>> classes;
+    for (auto &s : signatures) {
+        if (s.second.size() < 2) continue;
+        classes.emplace_back(s.second);
+        sort(classes.back().begin(), classes.back().end(), cmp);
+    }
+    return classes;
+}
+
+
 void Model::SimplifyModelByRandomSimulation() {
     m_log.L(1, "Simplify model by random simulation.");
     if (m_equivalenceSolver != nullptr) m_equivalenceSolver = nullptr;
@@ -608,27 +671,31 @@ void Model::SimplifyModelByRandomSimulation() {
     EncodeStatesToN64Signatuers(simulation_values, eqcheck_latches, signaturesVariablesMap);
 
     // signatures to equivalent variables
-    for (auto &s : signaturesVariablesMap) {
-        if (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start_time).count() > m_settings.eqTimeout) {
-            m_log.L(1, "Equivalent latch checking timeout after ", m_settings.eqTimeout, " seconds.");
-            break;
-        }
+    if (m_settings.eqThreads > 1) {
+        CheckEquivalenceClassesInParallel(CandidateClasses(signaturesVariablesMap), true, start_time, mayeq_counter, eq_counter);
+    } else {
+        for (auto &s : signaturesVariablesMap) {
+            if (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start_time).count() > m_settings.eqTimeout) {
+                m_log.L(1, "Equivalent latch checking timeout after ", m_settings.eqTimeout, " seconds.");
+                break;
+            }
 
-        if (s.second.size() < 2) continue;
+            if (s.second.size() < 2) continue;
 
-        vector<int> may_equal_vars(s.second);
-        sort(may_equal_vars.begin(), may_equal_vars.end(), cmp);
+            vector<int> may_equal_vars(s.second);
+            sort(may_equal_vars.begin(), may_equal_vars.end(), cmp);
 
-        for (int i = 0; i < may_equal_vars.size() - 1; i++) {
-            if (m_equivalenceManager->HasEquivalence(may_equal_vars[i])) continue;
+            for (int i = 0; i < may_equal_vars.size() - 1; i++) {
+                if (m_equivalenceManager->HasEquivalence(may_equal_vars[i])) continue;
 
-            for (int j = i + 1; j < may_equal_vars.size(); j++) {
-                if (m_equivalenceManager->HasEquivalence(may_equal_vars[j])) continue;
+                for (int j = i + 1; j < may_equal_vars.size(); j++) {
+                    if (m_equivalenceManager->HasEquivalence(may_equal_vars[j])) continue;
 
-                mayeq_counter++;
-                if (CheckLatchEquivalenceBySAT(may_equal_vars[i], may_equal_vars[j])) {
-                    eq_counter++;
-                    m_equivalenceManager->AddEquivalence(may_equal_vars[i], may_equal_vars[j]);
+                    mayeq_counter++;
+                    if (CheckLatchEquivalenceBySAT(may_equal_vars[i], may_equal_vars[j])) {
+                        eq_counter++;
+                        m_equivalenceManager->AddEquivalence(may_equal_vars[i], may_equal_vars[j]);
+                    }
                 }
             }
         }
@@ -647,51 +714,55 @@ void Model::SimplifyModelByRandomSimulation() {
     eq_counter = 0;
 
     // signatures to equivalent variables
-    for (auto &s : signaturesVariablesMap) {
-        if (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start_time).count() > m_settings.eqTimeout) {
-            m_log.L(1, "Equivalent gate checking timeout after ", m_settings.eqTimeout, " seconds.");
-            break;
-        }
-        if (s.second.size() < 2) continue;
-
-        vector<int> may_equal_vars(s.second);
-        sort(may_equal_vars.begin(), may_equal_vars.end(), cmp);
-
-        if (may_equal_vars.size() <= 3) {
-            for (int i = 0; i + 1 < may_equal_vars.size(); i++) {
-                for (int j = i + 1; j < may_equal_vars.size(); j++) {
-                    int a = may_equal_vars[i];
-                    int b = may_equal_vars[j];
-                    if (m_equivalenceManager->IsEquivalent(a, b)) {
-                        continue;
-                    }
-                    mayeq_counter++;
-                    if (CheckGateEquivalenceBySAT(a, b)) {
-                        eq_counter++;
-                        m_equivalenceManager->AddEquivalence(a, b);
-                    }
-                }
+    if (m_settings.eqThreads > 1) {
+        CheckEquivalenceClassesInParallel(CandidateClasses(signaturesVariablesMap), false, start_time, mayeq_counter, eq_counter);
+    } else {
+        for (auto &s : signaturesVariablesMap) {
+            if (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start_time).count() > m_settings.eqTimeout) {
+                m_log.L(1, "Equivalent gate checking timeout after ", m_settings.eqTimeout, " seconds.");
+                break;
             }
-        } else {
-            int k_rep = std::min<int>(3, may_equal_vars.size());
-            vector<int> reps(may_equal_vars.begin(), may_equal_vars.begin() + k_rep);
-            for (int i = k_rep; i < may_equal_vars.size(); i++) {
-                int v = may_equal_vars[i];
-                bool already_equiv = false;
-                for (int r : reps) {
-                    if (m_equivalenceManager->IsEquivalent(r, v)) {
-                        already_equiv = true;
-                        break;
+            if (s.second.size() < 2) continue;
+
+            vector<int> may_equal_vars(s.second);
+            sort(may_equal_vars.begin(), may_equal_vars.end(), cmp);
+
+            if (may_equal_vars.size() <= 3) {
+                for (int i = 0; i + 1 < may_equal_vars.size(); i++) {
+                    for (int j = i + 1; j < may_equal_vars.size(); j++) {
+                        int a = may_equal_vars[i];
+                        int b = may_equal_vars[j];
+                        if (m_equivalenceManager->IsEquivalent(a, b)) {
+                            continue;
+                        }
+                        mayeq_counter++;
+                        if (CheckGateEquivalenceBySAT(a, b)) {
+                            eq_counter++;
+                            m_equivalenceManager->AddEquivalence(a, b);
+                        }
                     }
                 }
-                if (already_equiv) continue;
-
-                for (int r : reps) {
-                    mayeq_counter++;
-                    if (CheckGateEquivalenceBySAT(r, v)) {
-                        eq_counter++;
-                        m_equivalenceManager->AddEquivalence(r, v);
-                        break;
+            } else {
+                int k_rep = std::min<int>(3, may_equal_vars.size());
+                vector<int> reps(may_equal_vars.begin(), may_equal_vars.begin() + k_rep);
+                for (int i = k_rep; i < may_equal_vars.size(); i++) {
+                    int v = may_equal_vars[i];
+                    bool already_equiv = false;
+                    for (int r : reps) {
+                        if (m_equivalenceManager->IsEquivalent(r, v)) {
+                            already_equiv = true;
+                            break;
+                        }
+                    }
+                    if (already_equiv) continue;
+
+                    for (int r : reps) {
+                        mayeq_counter++;
+                        if (CheckGateEquivalenceBySAT(r, v)) {
+                            eq_counter++;
+                            m_equivalenceManager->AddEquivalence(r, v);
+                            break;
+                        }
                     }
                 }
             }
@@ -761,37 +832,14 @@ void Model::EncodeStatesToN64Signatuers(const vector<vector<tbool>> &values, con
 
 bool Model::CheckLatchEquivalenceBySAT(int a, int b) {
     // initial step
-    if (m_circuitGraph->latchResetMap.find(abs(a)) == m_circuitGraph->latchResetMap.end())
-        return false;
-    int init_a = (a > 0) ? m_circuitGraph->latchResetMap[a] : -m_circuitGraph->latchResetMap[-a];
-    if (b == TrueId() && init_a != TrueId()) {
-        return false;
-    } else if (b == -TrueId() && init_a != -TrueId()) {
-        return false;
-    } else {
-        if (m_circuitGraph->latchResetMap.find(abs(b)) == m_circuitGraph->latchResetMap.end())
-            return false;
-        int init_b = (b > 0) ? m_circuitGraph->latchResetMap[b] : -m_circuitGraph->latchResetMap[-b];
-        if (init_a != init_b) return false;
-    }
+    if (!HasSameInitialValue(a, b)) return false;
 
     // inductive step
     if (m_equivalenceSolver == nullptr ||
         m_eqSolverUnsats > 1000) {
         m_eqSolverUnsats = 0;
-        ApplyEquivalence();
-        // UpdateDependencyMap();
-        CollectNextValueMapping();
-        CollectClauses();
-        SimplifyDAGClauses();
-        UpdateDependencyVecDAGCNF();
-
-        m_equivalenceSolver = make_unique<minicore::Solver>();
-        for (auto &c : m_clauses) {
-            m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec(c));
-        }
-        m_equivalenceSolver->solve_in_domain = true;
-        // m_equivalenceSolver->verbosity = 1;
+        RebuildEquivalenceClauses();
+        m_equivalenceSolver = NewEquivalenceSolver(false);
     }
 
     // (a <-> b) -> (a' <-> b')
@@ -799,39 +847,11 @@ bool Model::CheckLatchEquivalenceBySAT(int a, int b) {
     // (a | !b) & (!a | b) & (a' | b') & (!a' | !b')
     int a_prime = GetPrime(a);
     int b_prime = GetPrime(b);
-    {
-        // only keep temp act var
-        // need to be more robust in the future
-        std::vector<char> &dom = m_equivalenceSolver->domainSet();
-        std::fill(dom.begin() + 1, dom.end(), 0);
-        m_equivalenceSolver->domainList().resize(1);
-    }
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({a, -b}));
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({-a, b}));
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({a_prime, b_prime}));
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({-a_prime, -b_prime}));
-
     cube d = GetCOIDomain(cube{abs(a), abs(b), abs(a_prime), abs(b_prime)});
-    {
-        std::vector<char> &dom = m_equivalenceSolver->domainSet();
-        std::vector<minicore::Var> &list = m_equivalenceSolver->domainList();
-        for (auto v : d) {
-            while (v >= m_equivalenceSolver->nVars()) m_equivalenceSolver->newVar();
-            if (!dom[v]) {
-                dom[v] = 1;
-                list.push_back(v);
-            }
-        }
-    }
-
-    minicore::lbool res = m_equivalenceSolver->solve();
-    bool unsat = (res == minicore::l_False);
-
-    if (unsat) {
-        m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec({a, -b}));
-        m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec({-a, b}));
-        m_eqSolverUnsats++;
-    }
+    bool unsat = SolveEquivalence(*m_equivalenceSolver,
+                                  {{a, -b}, {-a, b}, {a_prime, b_prime}, {-a_prime, -b_prime}},
+                                  d, a, b);
+    if (unsat) m_eqSolverUnsats++;
     return unsat;
 }
 
@@ -840,40 +860,73 @@ bool Model::CheckGateEquivalenceBySAT(int a, int b) {
     if (m_equivalenceSolver == nullptr ||
         m_eqSolverUnsats > 1000) {
         m_eqSolverUnsats = 0;
-        ApplyEquivalence();
-        // UpdateDependencyMap();
-        CollectNextValueMapping();
-        CollectClauses();
-        SimplifyDAGClauses();
-        UpdateDependencyVecDAGCNF();
-
-        m_equivalenceSolver = make_unique<minicore::Solver>();
-        m_equivalenceSolver->setRestartLimit(1);
-        for (auto &c : m_clauses) {
-            m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec(c));
-        }
-        m_equivalenceSolver->solve_in_domain = true;
+        RebuildEquivalenceClauses();
+        m_equivalenceSolver = NewEquivalenceSolver(true);
     }
 
     // (a <-> b)
     // !(a <-> b) is unsat
     // ((a & !b) | (b & !a))
     // (a | b) & (!a | !b)
+    cube d = GetCOIDomain(cube{abs(a), abs(b)});
+    bool unsat = SolveEquivalence(*m_equivalenceSolver, {{a, b}, {-a, -b}}, d, a, b);
+    if (unsat) m_eqSolverUnsats++;
+    return unsat;
+}
+
+
+void Model::RebuildEquivalenceClauses() {
+    ApplyEquivalence();
+    // UpdateDependencyMap();
+    CollectNextValueMapping();
+    CollectClauses();
+    SimplifyDAGClauses();
+    UpdateDependencyVecDAGCNF();
+}
+
+
+unique_ptr<minicore::Solver> Model::NewEquivalenceSolver(bool gates) const {
+    auto solver = make_unique<minicore::Solver>();
+    if (gates) solver->setRestartLimit(1);
+    for (auto &c : m_clauses) {
+        solver->addClause(solver->intVec2LitVec(c));
+    }
+    solver->solve_in_domain = true;
+    return solver;
+}
+
+
+bool Model::HasSameInitialValue(int a, int b) {
+    const auto &resetMap = m_circuitGraph->latchResetMap;
+    auto it_a = resetMap.find(abs(a));
+    if (it_a == resetMap.end()) return false;
+    int init_a = (a > 0) ? it_a->second : -it_a->second;
+    if (b == TrueId()) return init_a == TrueId();
+    if (b == -TrueId()) return init_a == -TrueId();
+
+    auto it_b = resetMap.find(abs(b));
+    if (it_b == resetMap.end()) return false;
+    int init_b = (b > 0) ? it_b->second : -it_b->second;
+    return init_a == init_b;
+}
+
+
+bool Model::SolveEquivalence(minicore::Solver &solver, const vector<clause> &query, const cube &domain, int a, int b) const {
     {
         // only keep temp act var
-        std::vector<char> &dom = m_equivalenceSolver->domainSet();
+        // need to be more robust in the future
+        std::vector<char> &dom = solver.domainSet();
         std::fill(dom.begin() + 1, dom.end(), 0);
-        m_equivalenceSolver->domainList().resize(1);
+        solver.domainList().resize(1);
+    }
+    for (auto &c : query) {
+        solver.addTempClause(solver.intVec2LitVec(c));
     }
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({a, b}));
-    m_equivalenceSolver->addTempClause(m_equivalenceSolver->intVec2LitVec({-a, -b}));
-
-    cube d = GetCOIDomain(cube{abs(a), abs(b)});
     {
-        std::vector<char> &dom = m_equivalenceSolver->domainSet();
-        std::vector<minicore::Var> &list = m_equivalenceSolver->domainList();
-        for (auto v : d) {
-            while (v >= m_equivalenceSolver->nVars()) m_equivalenceSolver->newVar();
+        std::vector<char> &dom = solver.domainSet();
+        std::vector<minicore::Var> &list = solver.domainList();
+        for (auto v : domain) {
+            while (v >= solver.nVars()) solver.newVar();
             if (!dom[v]) {
                 dom[v] = 1;
                 list.push_back(v);
@@ -881,15 +934,153 @@ bool Model::CheckGateEquivalenceBySAT(int a, int b) {
         }
     }
 
-    minicore::lbool res = m_equivalenceSolver->solve();
+    minicore::lbool res = solver.solve();
     bool unsat = (res == minicore::l_False);
 
     if (unsat) {
-        m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec({a, -b}));
-        m_equivalenceSolver->addClause(m_equivalenceSolver->intVec2LitVec({-a, b}));
-        m_eqSolverUnsats++;
+        solver.addClause(solver.intVec2LitVec({a, -b}));
+        solver.addClause(solver.intVec2LitVec({-a, b}));
     }
     return unsat;
 }
 
+
+cube Model::CollectCOIDomain(const cube &c, vector<uint8_t> &visited) {
+    cube domain;
+    for (int v : c) {
+        int a = abs(v);
+        if (!visited[a]) {
+            visited[a] = 1;
+            domain.emplace_back(a);
+        }
+    }
+    for (size_t i = 0; i < domain.size(); ++i) {
+        for (int d : m_dependencyVec[domain[i]]) {
+            if (!visited[d]) {
+                visited[d] = 1;
+                domain.emplace_back(d);
+            }
+        }
+    }
+
+    for (int v : domain) visited[v] = 0;
+    domain.emplace_back(abs(TrueId()));
+    return domain;
+}
+
+
+void Model::CheckEquivalenceClassesInParallel(const vector<vector<int>> &classes, bool latches,
+                                              chrono::steady_clock::time_point start_time,
+                                              int &mayeq_counter, int &eq_counter) {
+    // every worker checks against the same snapshot, the equivalences are applied by the next phase
+    RebuildEquivalenceClauses();
+
+    // the workers only read the shared manager, the roots of the gates are resolved up front
+    // because Find compresses paths
+    unordered_map<int, int> roots;
+    if (!latches) {
+        for (auto &cls : classes)
+            for (int v : cls) roots.emplace(v, m_equivalenceManager->Find(v));
+    }
+
+    int threads = m_settings.eqThreads;
+    WorkerPool pool(threads);
+    vector<unique_ptr<minicore::Solver>> solvers(threads);
+    vector<vector<uint8_t>> visited(threads, vector<uint8_t>(m_dependencyVec.size(), 0));
+    vector<vector<pair<int, int>>> proven(classes.size());
+    vector<int> tried(classes.size(), 0);
+    atomic<bool> timeout(false);
+
+    pool.ParallelFor(classes.size(), [&](int worker, size_t index) {
+        if (timeout.load(memory_order_relaxed)) return;
+        if (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - start_time).count() > m_settings.eqTimeout) {
+            timeout.store(true, memory_order_relaxed);
+            return;
+        }
+
+        auto &solver = solvers[worker];
+        if (solver == nullptr) solver = NewEquivalenceSolver(!latches);
+        auto &vis = visited[worker];
+        const vector<int> &vars = classes[index];
+
+        if (latches) {
+            // same pairs as the serial loop, a proven latch is merged below its partner
+            unordered_set<int> merged;
+            auto has_equivalence = [&](int v) {
+                return m_equivalenceManager->HasEquivalence(v) || merged.count(abs(v)) > 0;
+            };
+            for (int i = 0; i + 1 < vars.size(); i++) {
+                if (has_equivalence(vars[i])) continue;
+                for (int j = i + 1; j < vars.size(); j++) {
+                    if (has_equivalence(vars[j])) continue;
+
+                    int a = vars[i], b = vars[j];
+                    tried[index]++;
+                    if (!HasSameInitialValue(a, b)) continue;
+                    int a_prime = GetPrime(a);
+                    int b_prime = GetPrime(b);
+                    cube d = CollectCOIDomain(cube{abs(a), abs(b), abs(a_prime), abs(b_prime)}, vis);
+                    if (SolveEquivalence(*solver, {{a, -b}, {-a, b}, {a_prime, b_prime}, {-a_prime, -b_prime}}, d, a, b)) {
+                        proven[index].emplace_back(a, b);
+                        merged.insert(abs(b));
+                    }
+                }
+            }
+            return;
+        }
+
+        // gates, a local union-find over the global roots
+        EquivalenceManager local;
+        auto is_equivalent = [&](int a, int b) {
+            return local.IsEquivalent(roots.at(a), roots.at(b));
+        };
+        auto check = [&](int a, int b) {
+            tried[index]++;
+            cube d = CollectCOIDomain(cube{abs(a), abs(b)}, vis);
+            if (!SolveEquivalence(*solver, {{a, b}, {-a, -b}}, d, a, b)) return false;
+            proven[index].emplace_back(a, b);
+            local.AddEquivalence(roots.at(a), roots.at(b));
+            return true;
+        };
+
+        if (vars.size() <= 3) {
+            for (int i = 0; i + 1 < vars.size(); i++) {
+                for (int j = i + 1; j < vars.size(); j++) {
+                    if (is_equivalent(vars[i], vars[j])) continue;
+                    check(vars[i], vars[j]);
+                }
+            }
+        } else {
+            int k_rep = 3;
+            for (int i = k_rep; i < vars.size(); i++) {
+                int v = vars[i];
+                bool already_equiv = false;
+                for (int r = 0; r < k_rep; r++) {
+                    if (is_equivalent(vars[r], v)) {
+                        already_equiv = true;
+                        break;
+                    }
+                }
+                if (already_equiv) continue;
+
+                for (int r = 0; r < k_rep; r++) {
+                    if (check(vars[r], v)) break;
+                }
+            }
+        }
+    });
+
+    if (timeout.load())
+        m_log.L(1, "Equivalent ", latches ? "latch" : "gate", " checking timeout after ", m_settings.eqTimeout, " seconds.");
+
+    // merge in class order, so the result does not depend on the schedule
+    for (size_t i = 0; i < classes.size(); ++i) {
+        mayeq_counter += tried[i];
+        for (auto &p : proven[i]) {
+            eq_counter++;
+            m_equivalenceManager->AddEquivalence(p.first, p.second);
+        }
+    }
+}
+
 } // namespace car
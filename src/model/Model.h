@@ -19,6 +19,7 @@ extern "C" {
 #include <iostream>
 #include <math.h>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <tuple>
@@ -163,6 +164,8 @@ class Model {
 
     inline shared_ptr<aiger> GetAiger() { return m_aiger; }
 
+    inline shared_ptr<CircuitGraph> GetCircuitGraph() { return m_circuitGraph; }
+
     inline int GetNumInputs() { return m_circuitGraph->numInputs; }
     inline int GetNumLatches() { return m_circuitGraph->numLatches; }
     inline vector<int> &GetInitialState() { return m_initialState; }
@@ -174,14 +177,30 @@ class Model {
     inline int GetBad() { return m_bad; }
     inline int GetProperty() { return -m_bad; }
 
+    inline int GetNumProperties() { return m_circuitGraph->bad.size(); }
+
+    // selects the bad output the engines check, not safe while an engine runs
+    void SetProperty(int index);
+
+    // property indexes grouped by overlapping cone of influence, in order
+    vector<vector<int>> GetPropertyGroups();
+
+    // read-only after construction, safe to call from concurrent engines
     inline int GetPrime(const int id) {
-        unordered_map<int, int>::iterator it = m_primeMaps[0].find(abs(id));
-        if (it == m_primeMaps[0].end()) return 0;
+        unordered_map<int, int>::iterator it = m_primeMap.find(abs(id));
+        if (it == m_primeMap.end()) return 0;
         return id > 0 ? it->second : -(it->second);
     }
 
+    // allocates the k-step copies lazily, serialized by m_primeMutex once shared
     int GetPrimeK(const int id, int k);
 
+    // engines unrolling the model from several threads, set before they start
+    void SetSharedUnrolling() { m_sharedUnrolling = true; }
+
+    // a fresh variable that no k-step copy will take, e.g. for selectors
+    int GetNewAuxiliaryId();
+
     vector<clause> &GetClauses() { return m_clauses; }
 
     vector<clause> &GetSimpClauses() { return m_simpClauses; }
@@ -213,6 +232,9 @@ class Model {
 
     const vector<vector<int>> &GetDependencyVec() const { return m_dependencyVec; }
 
+    // indices into GetClauses() of the clauses defining each variable, i.e. with it as the last literal
+    const vector<vector<int>> &GetDefiningClauses() const { return m_definingClauses; }
+
     const unordered_map<int, int> &GetEquivalenceMap() const {
         return m_equivalenceManager->GetEquivalenceMap();
     }
@@ -249,6 +271,22 @@ class Model {
 
     bool CheckGateEquivalenceBySAT(int a, int b);
 
+    // proves the candidate classes on eqThreads workers, each with its own solver over one snapshot of the model
+    void CheckEquivalenceClassesInParallel(const vector<vector<int>> &classes, bool latches,
+                                           chrono::steady_clock::time_point start_time,
+                                           int &mayeq_counter, int &eq_counter);
+
+    void RebuildEquivalenceClauses();
+
+    unique_ptr<minicore::Solver> NewEquivalenceSolver(bool gates) const;
+
+    bool HasSameInitialValue(int a, int b);
+
+    bool SolveEquivalence(minicore::Solver &solver, const vector<clause> &query, const cube &domain, int a, int b) const;
+
+    // GetCOIDomain without the shared caches, safe for concurrent callers
+    cube CollectCOIDomain(const cube &c, vector<uint8_t> &visited);
+
     void EnsureCOICache(int v);
 
     inline int GetNewId() { return ++m_maxId; };
@@ -265,10 +303,14 @@ class Model {
     vector<clause> m_simpClauses;
     vector<clause> m_initialClauses;
 
-    vector<unordered_map<int, int>> m_primeMaps;
+    unordered_map<int, int> m_primeMap;          // latches and innards to their next-state ids
+    vector<unordered_map<int, int>> m_primeMaps; // the other variables at step k (index k - 1)
+    mutex m_primeMutex;
+    bool m_sharedUnrolling = false;
     unordered_map<int, vector<int>> m_preValueOfLatchMap;
 
     vector<vector<int>> m_dependencyVec;
+    vector<vector<int>> m_definingClauses;
 
     vector<vector<int>> m_coiCache;
     vector<uint8_t> m_coiCacheReady;
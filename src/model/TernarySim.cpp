@@ -293,4 +293,129 @@ string TernarySimulator::stepValuesToString(int step) {
 }
 
 
+TernaryLifter::TernaryLifter(shared_ptr<CircuitGraph> circuitGraph)
+    : m_circuitGraph(circuitGraph) {
+    m_maxVar = max(static_cast<int>(circuitGraph->numVar), abs(circuitGraph->trueId));
+    for (int gid : circuitGraph->modelGates) {
+        m_maxVar = max(m_maxVar, gid);
+        for (int f : circuitGraph->gatesMap[gid].fanins) m_maxVar = max(m_maxVar, abs(f));
+    }
+    m_values.assign(m_maxVar + 1, t_Undef);
+    m_fanouts.resize(m_maxVar + 1);
+    m_order.assign(m_maxVar + 1, -1);
+    m_isTarget.assign(m_maxVar + 1, 0);
+    m_queued.assign(m_maxVar + 1, 0);
+    for (int i = 0; i < circuitGraph->modelGates.size(); i++) {
+        int gid = circuitGraph->modelGates[i];
+        m_order[gid] = i;
+        for (int f : circuitGraph->gatesMap[gid].fanins) m_fanouts[abs(f)].emplace_back(gid);
+    }
+}
+
+
+tbool TernaryLifter::evaluate(const CircuitGate &g) const {
+    switch (g.gateType) {
+    case CircuitGate::GateType::XOR:
+        return getVal(g.fanins[0]) ^ getVal(g.fanins[1]);
+    case CircuitGate::GateType::ITE:
+        return ite(getVal(g.fanins[0]), getVal(g.fanins[1]), getVal(g.fanins[2]));
+    case CircuitGate::GateType::AND:
+        return getVal(g.fanins[0]) && getVal(g.fanins[1]);
+    default:
+        assert(false);
+        return t_Undef;
+    }
+}
+
+
+void TernaryLifter::simulateAll() {
+    for (int gid : m_circuitGraph->modelGates) {
+        m_values[gid] = evaluate(m_circuitGraph->gatesMap[gid]);
+    }
+}
+
+
+// sets var to X and simulates its fanout cone in topological order,
+// false as soon as a target loses its value, the trail has every change for undo()
+bool TernaryLifter::setUndef(int var) {
+    m_trail.emplace_back(var, m_values[var]);
+    m_values[var] = t_Undef;
+    if (m_isTarget[var]) return false;
+
+    bool ok = true;
+    for (int g : m_fanouts[var]) {
+        if (m_queued[g]) continue;
+        m_queued[g] = 1;
+        m_queue.emplace(m_order[g], g);
+    }
+    while (!m_queue.empty()) {
+        int g = m_queue.top().second;
+        m_queue.pop();
+        m_queued[g] = 0;
+        if (!ok) continue;
+
+        tbool old_val = m_values[g];
+        tbool new_val = evaluate(m_circuitGraph->gatesMap[g]);
+        // values only turn from definite to X here
+        if (!(old_val == t_True || old_val == t_False) || new_val == old_val) continue;
+        m_trail.emplace_back(g, old_val);
+        m_values[g] = new_val;
+        if (m_isTarget[g]) {
+            ok = false;
+            continue;
+        }
+        for (int h : m_fanouts[g]) {
+            if (m_queued[h]) continue;
+            m_queued[h] = 1;
+            m_queue.emplace(m_order[h], h);
+        }
+    }
+    return ok;
+}
+
+
+void TernaryLifter::undo() {
+    for (auto it = m_trail.rbegin(); it != m_trail.rend(); ++it) m_values[it->first] = it->second;
+    m_trail.clear();
+}
+
+
+bool TernaryLifter::Lift(const vector<int> &inputs, vector<int> &latches, const vector<int> &targets) {
+    fill(m_values.begin(), m_values.end(), t_Undef);
+    int true_id = m_circuitGraph->trueId;
+    m_values[abs(true_id)] = tbool(true_id > 0);
+    for (int l : inputs) {
+        if (abs(l) > m_maxVar) return false;
+        m_values[abs(l)] = tbool(l > 0);
+    }
+    for (int l : latches) {
+        if (abs(l) > m_maxVar || m_circuitGraph->latchesSet.count(abs(l)) == 0) return false;
+        m_values[abs(l)] = tbool(l > 0);
+    }
+    simulateAll();
+    for (int t : targets) {
+        if (t == 0 || abs(t) > m_maxVar || !(getVal(t) == t_True)) return false;
+    }
+
+    for (int t : targets) m_isTarget[abs(t)] = 1;
+    vector<uint8_t> dropped(latches.size(), 0);
+    for (int i = static_cast<int>(latches.size()) - 1; i >= 0; i--) {
+        if (setUndef(abs(latches[i]))) {
+            dropped[i] = 1;
+            m_trail.clear();
+        } else {
+            undo();
+        }
+    }
+    for (int t : targets) m_isTarget[abs(t)] = 0;
+
+    size_t j = 0;
+    for (size_t i = 0; i < latches.size(); i++) {
+        if (!dropped[i]) latches[j++] = latches[i];
+    }
+    latches.resize(j);
+    return true;
+}
+
+
 } // namespace car
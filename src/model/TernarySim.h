@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <queue>
 #include <random>
 
 namespace car {
@@ -126,6 +127,51 @@ class TernarySimulator {
     string stepValuesToString(int step);
 };
 
+// lifts a state by ternary simulation: a latch is set to X and only its fanout cone
+// is simulated again, the latch can go if every target stays definitely true
+class TernaryLifter {
+  public:
+    TernaryLifter(shared_ptr<CircuitGraph> circuitGraph);
+    ~TernaryLifter() {};
+
+    // latches are tried from the back, the ones that stay keep their order.
+    // false if a target is not definitely true under the whole state,
+    // latches are not touched then
+    bool Lift(const vector<int> &inputs, vector<int> &latches, const vector<int> &targets);
+
+  private:
+    tbool getVal(int id) const {
+        tbool v = m_values[abs(id)];
+        return (id > 0) ? v : !v;
+    }
+
+    tbool evaluate(const CircuitGate &g) const;
+
+    void simulateAll();
+
+    bool setUndef(int var);
+
+    void undo();
+
+    shared_ptr<CircuitGraph> m_circuitGraph;
+
+    int m_maxVar;
+
+    vector<tbool> m_values;
+
+    vector<vector<int>> m_fanouts; // gates reading a variable
+
+    vector<int> m_order; // position of a gate in modelGates, -1 for other variables
+
+    vector<uint8_t> m_isTarget;
+
+    vector<uint8_t> m_queued;
+
+    vector<pair<int, tbool>> m_trail;
+
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> m_queue;
+};
+
 } // namespace car
 
 #endif // TERNARY_SIM_H
@@ -23,7 +23,7 @@ bool CadicalSolver::Solve() {
     if (result == 10) {
         return true;
     } else {
-        assert(result == 20);
+        assert(result == 20 || result == 0); // 0 after Interrupt
         return false;
     }
 }
@@ -104,14 +104,8 @@ pair<cube, cube> CadicalSolver::GetAssignment(bool prime) {
 }
 
 
-unordered_set<int> CadicalSolver::GetConflict() {
-    unordered_set<int> conflictSet;
-    for (auto v : m_assumptions) {
-        if (failed(v)) {
-            conflictSet.insert(v);
-        }
-    }
-    return conflictSet;
+bool CadicalSolver::IsFailed(int lit) {
+    return failed(lit);
 }
 
 void CadicalSolver::AddTempClause(const cube &cls) {
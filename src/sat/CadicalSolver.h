@@ -18,7 +18,7 @@ class CadicalSolver : public ISolver, public CaDiCaL::Solver {
     bool Solve() override;
     bool Solve(const cube &assumption) override;
     pair<cube, cube> GetAssignment(bool prime) override;
-    unordered_set<int> GetConflict() override;
+    bool IsFailed(int lit) override;
     inline int GetNewVar() override {
         return ++m_maxId;
     }
@@ -35,6 +35,7 @@ class CadicalSolver : public ISolver, public CaDiCaL::Solver {
     void ClearAssumption() override;
     void PushAssumption(int a) override;
     int PopAssumption() override;
+    void Interrupt() override { terminate(); }
 
   protected:
     Model &m_model;
@@ -17,7 +17,8 @@ class ISolver {
     virtual bool Solve() = 0;
     virtual bool Solve(const cube &assumption) = 0;
     virtual pair<cube, cube> GetAssignment(bool prime) = 0;
-    virtual unordered_set<int> GetConflict() = 0;
+    // lit was assumed in the last UNSAT solve and is in its final conflict
+    virtual bool IsFailed(int lit) = 0;
     virtual int GetNewVar() = 0;
     virtual void AddTempClause(const cube &cls) = 0;
     virtual void ReleaseTempClause() = 0;
@@ -26,6 +27,8 @@ class ISolver {
     virtual void ClearAssumption() = 0;
     virtual void PushAssumption(int a) = 0;
     virtual int PopAssumption() = 0;
+    // asks a Solve running on another thread to give up, a no-op for backends that cannot
+    virtual void Interrupt() {}
 
   private:
 };
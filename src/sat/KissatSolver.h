@@ -25,7 +25,7 @@ class KissatSolver : public ISolver {
     bool Solve(const cube &assumption) override { return false; }
     pair<cube, cube> GetAssignment(bool prime) override { return pair<cube, cube>(cube(), cube()); }
     cube GetUC(bool prime) { return cube(); }
-    unordered_set<int> GetConflict() override { return unordered_set<int>(); }
+    bool IsFailed(int lit) override { return false; }
     int GetNewVar() override { return 0; }
     void AddTempClause(const cube &cls) override {}
     void ReleaseTempClause() override {}
@@ -93,13 +93,8 @@ pair<cube, cube> MinicoreSolver::GetAssignment(bool prime) {
 }
 
 
-unordered_set<int> MinicoreSolver::GetConflict() {
-    unordered_set<int> conflictSet;
-    for (minicore::Lit l : conflict) {
-        int val = -GetLiteralId(l);
-        conflictSet.insert(val);
-    }
-    return conflictSet;
+bool MinicoreSolver::IsFailed(int lit) {
+    return conflict.find(~GetLit(lit)) != conflict.end();
 }
 
 
@@ -18,7 +18,7 @@ class MinicoreSolver : public ISolver, public minicore::Solver {
     bool Solve() override;
     bool Solve(const cube &assumption) override;
     pair<cube, cube> GetAssignment(bool prime) override;
-    unordered_set<int> GetConflict() override;
+    bool IsFailed(int lit) override;
     inline int GetNewVar() override {
         return ++m_maxId;
     }
@@ -15,7 +15,7 @@ bool MinisatSolver::Solve() {
     if (result == Minisat::l_True) {
         return true;
     } else {
-        assert(result == Minisat::l_False);
+        assert(result == Minisat::l_False || asynch_interrupt);
         return false;
     }
 }
@@ -102,13 +102,10 @@ pair<cube, cube> MinisatSolver::GetAssignment(bool prime) {
     return pair<cube, cube>(inputs, latches);
 }
 
-unordered_set<int> MinisatSolver::GetConflict() {
-    unordered_set<int> conflictSet;
-    for (int i = 0; i < conflict.size(); ++i) {
-        int val = -GetLiteralId(conflict[i]);
-        conflictSet.insert(val);
-    }
-    return conflictSet;
+// the conflict is a clause over the negated assumptions, kept with a mark per literal
+bool MinisatSolver::IsFailed(int lit) {
+    if (abs(lit) >= nVars()) return false;
+    return conflict.has(~GetLit(lit));
 }
 
 
@@ -18,7 +18,7 @@ class MinisatSolver : public ISolver, public Minisat::Solver {
     bool Solve() override;
     bool Solve(const cube &assumption) override;
     pair<cube, cube> GetAssignment(bool prime) override;
-    unordered_set<int> GetConflict() override;
+    bool IsFailed(int lit) override;
     inline int GetNewVar() override {
         return ++m_maxId;
     }
@@ -36,6 +36,7 @@ class MinisatSolver : public ISolver, public Minisat::Solver {
     void ClearAssumption() override;
     void PushAssumption(int a) override;
     int PopAssumption() override;
+    void Interrupt() override { interrupt(); }
 
   protected:
     inline int GetLiteralId(const Minisat::Lit &l);
@@ -35,6 +35,7 @@ bool SATSolver::Solve() {
 }
 
 bool SATSolver::Solve(const cube &assumption) {
+    if (m_sliced) LoadSlice(assumption);
     return m_slv->Solve(assumption);
 }
 
@@ -156,6 +157,7 @@ void SATSolver::ResetTempDomain() {
 
 void SATSolver::SetDomainCOI(const cube &c) {
     if (!m_solveInDomain) return;
+    if (m_sliced) LoadSlice(c);
     auto slv = GetMinicoreSolver();
     if (!slv) return;
     AddPermanentVars(slv, c, true);
@@ -163,6 +165,7 @@ void SATSolver::SetDomainCOI(const cube &c) {
 
 void SATSolver::SetTempDomainCOI(const cube &c) {
     if (!m_solveInDomain) return;
+    if (m_sliced) LoadSlice(c);
     auto slv = GetMinicoreSolver();
     if (!slv) return;
     AddTemporaryVars(slv, c, true);
@@ -182,13 +185,55 @@ cube SATSolver::GetDomain() {
 }
 
 
+// ================================================================================
+// @brief: load the cone of influence of lits from the transition relation,
+//         stopping at variables loaded before, so each clause is added once
+// @input: literals about to occur in a clause, an assumption or a domain
+// @output:
+// ================================================================================
+void SATSolver::LoadSlice(int lit) {
+    size_t v = static_cast<size_t>(abs(lit));
+    if (v >= m_sliceLoaded.size() || m_sliceLoaded[v]) return;
+
+    auto &dep_map = m_model.GetDependencyVec();
+    auto &def_map = m_model.GetDefiningClauses();
+    vector<clause> &clauses = m_model.GetClauses();
+    m_sliceStack.clear();
+    m_sliceStack.emplace_back(v);
+    m_sliceLoaded[v] = 1;
+
+    while (!m_sliceStack.empty()) {
+        int cur = m_sliceStack.back();
+        m_sliceStack.pop_back();
+
+        for (int i : def_map[cur]) m_slv->AddClause(clauses[i]);
+        for (int d : dep_map[cur]) {
+            if (m_sliceLoaded[d]) continue;
+            m_sliceLoaded[d] = 1;
+            m_sliceStack.emplace_back(d);
+        }
+    }
+}
+
+void SATSolver::LoadSlice(const cube &lits) {
+    for (int l : lits) LoadSlice(l);
+}
+
+
 // ================================================================================
 // @brief: add transition relation to solver, & T
 // @input:
 // @output:
 // ================================================================================
 void SATSolver::AddTrans() {
-    if (m_solveInDomain) {
+    if (m_solveInDomain && GetMinicoreSolver() == nullptr) {
+        // only the cones reached by later clauses and assumptions are loaded,
+        // the tautology declares every model variable for GetAssignment
+        m_sliced = true;
+        m_sliceLoaded.assign(m_model.GetDependencyVec().size(), 0);
+        m_slv->AddClause(clause{m_model.NumVar(), -m_model.NumVar()});
+        LoadSlice(m_model.TrueId());
+    } else if (m_solveInDomain) {
         vector<clause> &clauses = m_model.GetClauses();
         for (int i = 0; i < clauses.size(); ++i) {
             AddClause(clauses[i]);
@@ -22,10 +22,12 @@ class SATSolver {
 
     // general SAT interface
     void AddClause(const cube &cls) {
+        if (m_sliced) LoadSlice(cls);
         m_slv->AddClause(cls);
     }
 
     void AddAssumption(const cube &assumption) {
+        if (m_sliced) LoadSlice(assumption);
         m_slv->AddAssumption(assumption);
     }
 
@@ -36,8 +38,15 @@ class SATSolver {
         return m_slv->GetAssignment(prime);
     }
 
-    unordered_set<int> GetConflict() {
-        return m_slv->GetConflict();
+    bool IsFailed(int lit) {
+        return m_slv->IsFailed(lit);
+    }
+
+    // appends the literals of c whose assumption failed, c' if prime, in the order of c
+    void GetFailed(const cube &c, bool prime, cube &out) {
+        for (int l : c) {
+            if (m_slv->IsFailed(prime ? m_model.GetPrimeK(l, 1) : l)) out.emplace_back(l);
+        }
     }
 
     int GetNewVar() {
@@ -45,6 +54,7 @@ class SATSolver {
     }
 
     void AddTempClause(const cube &cls) {
+        if (m_sliced) LoadSlice(cls);
         m_slv->AddTempClause(cls);
     }
 
@@ -61,6 +71,7 @@ class SATSolver {
     }
 
     void PushAssumption(int a) {
+        if (m_sliced) LoadSlice(a);
         m_slv->PushAssumption(a);
     }
 
@@ -68,7 +79,11 @@ class SATSolver {
         return m_slv->PopAssumption();
     }
 
-    // special interface in minicore
+    void Interrupt() {
+        m_slv->Interrupt();
+    }
+
+    // special interface in minicore, the other backends load the transition relation by COI slices instead
     void SetSolveInDomain();
 
     void SetDomain(const cube &domain);
@@ -131,8 +146,16 @@ class SATSolver {
     void AddTemporaryVars(shared_ptr<MinicoreSolver> solver, const cube &vars, bool use_coi);
     void ResetTemporaryVars(shared_ptr<MinicoreSolver> solver);
 
+    // adds the clauses of the not yet loaded part of the cone of influence of the literals
+    void LoadSlice(const cube &lits);
+    void LoadSlice(int lit);
+
     int m_true_id;
     size_t m_domain_fixed;
+
+    bool m_sliced = false;
+    vector<char> m_sliceLoaded; // a loaded variable has its whole cone loaded
+    vector<int> m_sliceStack;
 };
 
 } // namespace car